@@ -0,0 +1,22 @@
+-- Active: 1733128601746@@127.0.0.1@3306@My_First_DB
+
+-- 為 books / users 加上 version 欄位，每次寫入都會加一
+-- 程式端以 UPDATE ... WHERE version = ? 做 compare-and-set，
+-- 沒有更新到就代表別人先改過（回報衝突，而不是覆蓋）
+
+ALTER TABLE books
+ADD COLUMN version INT NOT NULL DEFAULT 0 AFTER status;
+
+ALTER TABLE users
+ADD COLUMN version INT NOT NULL DEFAULT 0 AFTER phone;
+
+-- 借書、還書的 procedure 與還書 trigger 也會更新 books.status，
+-- 需要一併遞增 version：借書由 borrow_book 遞增，還書只由
+-- after_return_update_stock trigger 遞增（return_book 不再重複加一）。
+-- 先刪除舊版本，再重新執行
+-- borrowing_method.sql、returning_method.sql 與 create_trigger.sql
+DROP PROCEDURE IF EXISTS borrow_book;
+DROP PROCEDURE IF EXISTS return_book;
+
+DESCRIBE books;
+DESCRIBE users;
@@ -38,7 +38,8 @@ BEGIN
         
         -- 更新書籍狀態
         UPDATE books 
-        SET status = 'borrowed'
+        SET status = 'borrowed',
+            version = version + 1
         WHERE qr_code = p_qr_code;
         
         -- 創建借閱記錄
@@ -32,12 +32,14 @@ BEGIN
             
             -- 書籍狀態改為reserved（表示被預約中）
             UPDATE books 
-            SET status = 'reserved'
+            SET status = 'reserved',
+                version = version + 1
             WHERE book_id = NEW.book_id;
         ELSE
             -- 如果沒有預約，就將書籍狀態改為可借閱
             UPDATE books 
-            SET status = 'available'
+            SET status = 'available',
+                version = version + 1
             WHERE book_id = NEW.book_id;
         END IF;
     END IF;
@@ -0,0 +1,131 @@
+#ifndef ASYNC_LOGGER_H
+#define ASYNC_LOGGER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+enum class LogLevel : uint8_t { Debug, Info, Warning, Error };
+
+// One log entry. Fixed-size so that it can live in a preallocated ring
+// slot; longer operation names, messages and queries are truncated.
+struct LogRecord {
+    LogLevel level;
+    std::chrono::system_clock::time_point time;
+    char operation[32];
+    char message[192];
+    char query[256];
+    uint32_t query_length;              // length before truncation
+    unsigned int error_code;            // mysql_errno(), 0 if none
+    uint32_t latency_us;                // 0 if not measured
+};
+
+// Process-wide logger with a background writer thread.
+//
+// Callers format nothing and never touch the output stream: log() claims
+// a slot in a bounded lock-free multi-producer ring, copies the fields in
+// and returns. If the ring is full the record is dropped and counted
+// rather than blocking the caller. The writer thread formats records,
+// applies the rate limit and writes them in batches, flushing the stream
+// once per batch.
+//
+// Repeated Warning/Error records with the same operation and error code
+// are limited to `burst` lines per window; the writer reports how many
+// were suppressed when the window ends.
+class AsyncLogger {
+public:
+    static AsyncLogger& getInstance();
+
+    ~AsyncLogger();
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    // Records below this level are discarded before they are queued.
+    // Default is Info.
+    void setLevel(LogLevel level) { level_.store(level, std::memory_order_relaxed); }
+    LogLevel level() const { return level_.load(std::memory_order_relaxed); }
+    bool enabled(LogLevel level) const { return level >= this->level(); }
+
+    void setRateLimit(unsigned int burst, std::chrono::milliseconds window);
+    // Defaults to std::cerr. The stream must outlive the logger.
+    void setOutput(std::ostream& out);
+
+    void log(LogLevel level, const char* operation, const std::string& message,
+             unsigned int error_code = 0,
+             std::chrono::microseconds latency = std::chrono::microseconds(0),
+             const std::string& query = std::string());
+
+    // Blocks until every record queued before the call has been written.
+    void flush();
+
+    // Records lost because the ring was full.
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr std::size_t kCapacity = 4096;      // power of two
+    static constexpr std::size_t kBatchSize = 256;      // records per write/flush
+
+    struct Slot {
+        std::atomic<std::size_t> sequence;
+        LogRecord record;
+    };
+
+    struct RateWindow {
+        std::chrono::steady_clock::time_point start;
+        unsigned int written = 0;
+        uint64_t suppressed = 0;
+    };
+
+    AsyncLogger();
+
+    bool tryPop(LogRecord& record);
+    void run();
+    void write(std::ostream& out, const LogRecord& record, unsigned int burst,
+               std::chrono::steady_clock::time_point now);
+    bool admit(const LogRecord& record, unsigned int burst, std::chrono::steady_clock::time_point now);
+    // Returns true if anything was written
+    bool reportSuppressed(std::ostream& out, std::chrono::milliseconds window,
+                          std::chrono::steady_clock::time_point now, bool all);
+
+    std::unique_ptr<Slot[]> slots_;
+    alignas(64) std::atomic<std::size_t> enqueue_pos_;
+    alignas(64) std::size_t dequeue_pos_;               // writer thread only
+
+    std::atomic<LogLevel> level_;
+    std::atomic<uint64_t> enqueued_;
+    std::atomic<uint64_t> dropped_;
+    std::atomic<bool> writer_idle_;
+
+    // Guards the writer's wake-ups and the settings below; producers only
+    // take it to wake an idle writer. The writer drains a batch under it
+    // and releases it before formatting and writing.
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable written_cv_;
+    unsigned int burst_;
+    std::chrono::milliseconds window_;
+    uint64_t written_;
+    bool stopping_;
+
+    // Held while writing to or replacing the output stream
+    std::mutex io_mutex_;
+    std::ostream* out_;
+
+    // Writer thread only
+    std::map<std::tuple<std::string, unsigned int, LogLevel>, RateWindow> windows_;
+
+    std::thread thread_;
+};
+
+#endif // ASYNC_LOGGER_H
@@ -0,0 +1,101 @@
+#ifndef BORROW_EXPORTER_H
+#define BORROW_EXPORTER_H
+
+#include "database.h"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Columnar export of borrow_records joined with books and users.
+//
+// File layout (all integers little-endian or LEB128 varints):
+//
+//   "LBCF" version:u8
+//   row group 0: column chunk 0 .. column chunk N-1
+//   row group 1: ...
+//   footer
+//   footer_size:u32 "LBCF"
+//
+// Each column chunk is zlib-compressed and encoded per column:
+//   - Delta:      zigzag varint differences (ids, and dates as days since
+//                 1970-01-01); nullable columns start with a presence bitmap
+//   - Dictionary: per-chunk dictionary followed by one varint index per row
+//   - Plain:      varint length + bytes per row
+// The footer lists the schema and, for every row group, its row count,
+// record_id range and the offset/size of each chunk, so a reader can fetch
+// just the columns it needs. NULL strings are exported as empty strings.
+
+enum class ColumnType : uint8_t { Int64 = 0, Date = 1, String = 2 };
+enum class ColumnEncoding : uint8_t { Plain = 0, Dictionary = 1, Delta = 2 };
+
+struct ColumnInfo {
+    std::string name;
+    ColumnType type;
+    ColumnEncoding encoding;
+    bool nullable;
+};
+
+struct ColumnChunkInfo {
+    uint64_t offset;
+    uint64_t compressed_size;
+    uint64_t raw_size;
+};
+
+struct RowGroupInfo {
+    uint64_t row_count;
+    int64_t min_record_id;
+    int64_t max_record_id;
+    std::vector<ColumnChunkInfo> chunks;   // one per column
+};
+
+struct ExportStats {
+    std::size_t rows = 0;
+    std::size_t row_groups = 0;
+    std::size_t bytes_written = 0;
+    double seconds = 0.0;
+};
+
+class BorrowRecordExporter {
+public:
+    // Rows are buffered one row group at a time, so memory use is bounded
+    // by row_group_size regardless of table size.
+    explicit BorrowRecordExporter(DatabaseConnection& db, std::size_t row_group_size = 65536);
+
+    // Streams the join with mysql_use_result on a side connection and writes
+    // the file. Throws std::runtime_error on database or I/O errors.
+    ExportStats exportTo(const std::string& path);
+
+    static const std::vector<ColumnInfo>& schema();
+
+private:
+    DatabaseConnection& db_;
+    std::size_t row_group_size_;
+};
+
+// Reads files written by BorrowRecordExporter, one column chunk at a time.
+class ColumnarReader {
+public:
+    // Throws std::runtime_error if the file is missing or malformed.
+    explicit ColumnarReader(const std::string& path);
+
+    const std::vector<ColumnInfo>& columns() const { return columns_; }
+    const std::vector<RowGroupInfo>& rowGroups() const { return row_groups_; }
+    int columnIndex(const std::string& name) const;   // -1 if unknown
+
+    // Int64 and Date columns (dates as days since 1970-01-01). For nullable
+    // columns `present` receives one flag per row.
+    std::vector<int64_t> readIntegers(std::size_t row_group, const std::string& column,
+                                      std::vector<bool>* present = nullptr);
+    std::vector<std::string> readStrings(std::size_t row_group, const std::string& column);
+
+private:
+    std::string readChunk(std::size_t row_group, std::size_t column);
+
+    std::ifstream in_;
+    std::vector<ColumnInfo> columns_;
+    std::vector<RowGroupInfo> row_groups_;
+};
+
+#endif // BORROW_EXPORTER_H
@@ -0,0 +1,94 @@
+#ifndef CIRCULATION_STATS_H
+#define CIRCULATION_STATS_H
+
+#include "database.h"
+#include "id_watermark.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Return lateness buckets, in days past due_date:
+//   on time, 1-3, 4-7, 8-14, 15-30, more than 30
+constexpr std::size_t kLatenessBuckets = 6;
+
+struct PatronStats {
+    uint64_t loans = 0;
+    uint64_t late_returns = 0;
+};
+
+// Aggregates carried from one run to the next. A run only scans records
+// the watermark has not seen (record_id above its high-water mark, or in
+// a gap left by a transaction that had not committed yet), plus the loans
+// that were still open last time (at most five per patron), so its cost
+// follows the day's activity rather than the size of the history.
+struct CirculationState {
+    IdWatermark watermark;
+    uint64_t total_loans = 0;
+    uint64_t returned_loans = 0;
+    uint64_t total_loan_days = 0;       // over returned loans
+    std::array<uint64_t, kLatenessBuckets> lateness{};
+    std::unordered_map<int, uint64_t> loans_per_book;
+    std::unordered_map<int, PatronStats> patrons;
+    std::unordered_map<int, int> open_loans;   // record_id -> user_id
+
+    // Plain-text persistence; load() returns false if the file is missing
+    // or unreadable, leaving the state empty (i.e. a full run).
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+};
+
+struct TitleCount {
+    int book_id;
+    std::string title;
+    uint64_t loans;
+};
+
+struct PatronActivity {
+    int user_id;
+    std::string card_id;
+    uint64_t loans;
+    uint64_t late_returns;
+};
+
+struct CirculationReport {
+    uint64_t total_loans = 0;
+    uint64_t returned_loans = 0;
+    uint64_t open_loans = 0;
+    uint64_t overdue_loans = 0;         // open and past due_date
+    double average_loan_days = 0.0;
+    std::array<uint64_t, kLatenessBuckets> lateness{};
+    std::vector<TitleCount> top_titles;
+    std::vector<PatronActivity> top_patrons;
+    uint64_t scanned_records = 0;       // new records read by this run
+    double seconds = 0.0;
+};
+
+// Computes circulation metrics from borrow_records.
+//
+// The new record_id range is split into one partition per worker; each
+// worker streams its partition over its own connection into thread-local
+// hash maps, which are merged into the state once all workers finish.
+// Gaps are re-read on the control connection and given up after
+// max_gap_age seconds or once they are gap_window ids behind.
+class CirculationStats {
+public:
+    explicit CirculationStats(DatabaseConnection& db, std::size_t workers = 4,
+                              long long gap_window = IdWatermark::kDefaultWindow,
+                              long long max_gap_age = IdWatermark::kDefaultMaxGapAge);
+
+    // Brings `state` up to date and reports from it. Pass a default
+    // constructed state for a full recomputation. Throws std::runtime_error
+    // on database errors, in which case `state` is left unchanged.
+    CirculationReport run(CirculationState& state, std::size_t top_n = 10);
+
+private:
+    DatabaseConnection& db_;
+    std::size_t workers_;
+    long long gap_window_;
+    long long max_gap_age_;
+};
+
+#endif // CIRCULATION_STATS_H
@@ -5,6 +5,16 @@
 #include <memory>
 #include <mysql/mysql.h>
 
+// Socket-level limits applied on every connect. Values are in seconds; zero
+// (the default) leaves the option unset and keeps the client library
+// default. Note that libmysqlclient retries reads, so a read can block for
+// up to three times read_seconds.
+struct ConnectionTimeouts {
+    unsigned int connect_seconds = 0;
+    unsigned int read_seconds = 0;
+    unsigned int write_seconds = 0;
+};
+
 class DatabaseConnection {
 private:
     std::string host_;
@@ -12,6 +22,7 @@ private:
     std::string password_;
     std::string database_;
     unsigned int port_;
+    ConnectionTimeouts timeouts_;
     MYSQL* connection_;
     
     // Singleton instance
@@ -42,11 +53,31 @@ public:
                          const std::string& database,
                          unsigned int port = 3306);
     
+    // Creates a connection that is independent of the singleton, for
+    // talking to several instances at once (e.g. one per shard).
+    static std::unique_ptr<DatabaseConnection> create(const std::string& host,
+                                                      const std::string& user,
+                                                      const std::string& password,
+                                                      const std::string& database,
+                                                      unsigned int port = 3306);
+    
     // Connection management
     bool connect();
     void disconnect();
     bool isConnected() const;
     
+    // Takes effect on the next connect()
+    void setTimeouts(const ConnectionTimeouts& timeouts) { timeouts_ = timeouts; }
+    const ConnectionTimeouts& getTimeouts() const { return timeouts_; }
+    
+    // Opens a separate connection to the same server with the same
+    // credentials, e.g. for issuing KILL QUERY. The caller owns the handle
+    // and must mysql_close() it. Returns nullptr on failure.
+    MYSQL* openSideConnection() const;
+    
+    // Server-side id of this connection (the id used by KILL)
+    unsigned long getThreadId() const;
+    
     // Basic database information
     std::string getCurrentDatabase() const;
     std::string getServerInfo() const;
@@ -3,63 +3,101 @@
 #define DATABASE_OPERATIONS_H
 
 #include "database.h"
+#include "library_storage.h"
+#include "query_watchdog.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <vector>
 #include <optional>
 #include <string>
 
-struct Book {
-    int id;
-    std::string qr_code;
-    std::string title;
-    std::string author;
-    std::string isbn;
-    int publication_year;
-    std::string status;
+// Why the most recent DatabaseOperations call failed
+enum class OperationError {
+    None,
+    Timeout,        // deadline exceeded; the statement was cancelled
+    Connection,     // could not (re)connect
+    Query           // the server rejected the statement
 };
 
-struct User {
-    int id;
-    std::string card_id;
-    std::string name;
-    std::string email;
-    std::string phone;
-};
-
-struct BorrowRecord {
-    int record_id;
-    int book_id;
-    int user_id;
-    std::string borrow_date;
-    std::string due_date;
-    std::optional<std::string> return_date;
-};
-
-class DatabaseOperations {
+class DatabaseOperations : public LibraryStorage {
 public:
+    // Operates on the DatabaseConnection singleton
+    DatabaseOperations();
+    // Operates on the given connection, which must outlive this object
+    explicit DatabaseOperations(DatabaseConnection& db);
+    ~DatabaseOperations() override;
+    
+    // Deadline for each public call below, covering every statement the
+    // call issues. Zero (the default) means no deadline.
+    void setOperationTimeout(std::chrono::milliseconds timeout);
+    OperationError lastError() const { return last_error_; }
+    
+    // Called after every statement with the SQL text, the number of rows
+    // returned (SELECT) or affected (other statements), and whether it
+    // succeeded; rows is 0 for a failed statement. Used by diagnostics such
+    // as PlanInspector; empty by default.
+    using StatementObserver = std::function<void(const std::string& query, uint64_t rows, bool ok)>;
+    void setStatementObserver(StatementObserver observer) { observer_ = std::move(observer); }
+    
     // Book operations
-    bool createBook(const Book& book);
-    std::optional<Book> getBook(const std::string& qr_code);
-    std::vector<Book> getAllBooks();
-    bool updateBook(const Book& book);
-    bool deleteBook(const std::string& qr_code);
+    bool createBook(const Book& book) override;
+    std::optional<Book> getBook(const std::string& qr_code) override;
+    std::unordered_map<std::string, std::optional<Book>>
+        getBooks(const std::vector<std::string>& qr_codes) override;
+    std::vector<Book> getAllBooks() override;
+    bool updateBook(const Book& book) override;
+    UpdateResult patchBook(const BookPatch& patch) override;
+    bool deleteBook(const std::string& qr_code) override;
     
     // User operations
-    bool createUser(const User& user);
-    std::optional<User> getUser(const std::string& card_id);
-    std::vector<User> getAllUsers();
-    bool updateUser(const User& user);
-    bool deleteUser(const std::string& card_id);
+    bool createUser(const User& user) override;
+    std::optional<User> getUser(const std::string& card_id) override;
+    std::unordered_map<std::string, std::optional<User>>
+        getUsers(const std::vector<std::string>& card_ids) override;
+    std::vector<User> getAllUsers() override;
+    bool updateUser(const User& user) override;
+    UpdateResult patchUser(const UserPatch& patch) override;
+    bool deleteUser(const std::string& card_id) override;
     
     // Borrow record operations
-    bool createBorrowRecord(const std::string& book_qr, const std::string& user_card);
-    bool returnBook(const std::string& book_qr);
-    std::vector<BorrowRecord> getUserBorrowHistory(const std::string& user_card);
-    std::vector<BorrowRecord> getBookBorrowHistory(const std::string& book_qr);
+    bool createBorrowRecord(const std::string& book_qr, const std::string& user_card) override;
+    bool returnBook(const std::string& book_qr) override;
+    std::vector<BorrowRecord> getUserBorrowHistory(const std::string& user_card) override;
+    std::vector<BorrowRecord> getBookBorrowHistory(const std::string& book_qr) override;
+    std::optional<std::size_t> countUserLoans(const std::string& user_card, bool open_only) override;
 
 private:
+    // Multi-get batches are capped by key count and by statement size so a
+    // single IN (...) query stays far below max_allowed_packet.
+    static constexpr std::size_t kMaxKeysPerBatch = 500;
+    static constexpr std::size_t kMaxBatchQueryBytes = 512 * 1024;
+
+    void beginOperation(const char* operation);
+    bool ensureConnection();
+    bool runStatement(MYSQL* conn, const std::string& query);
+    // Rolls back whatever a timed-out statement left open on conn
+    void abandonTransaction(MYSQL* conn);
     bool executeQuery(const std::string& query);
     MYSQL_RES* executeSelectQuery(const std::string& query);
+    MYSQL_RES* runSelectQuery(const std::string& query);
+    std::vector<std::string> buildInQueries(const std::string& prefix,
+                                            const std::vector<std::string>& keys);
     std::string escapeString(const std::string& str);
+    UpdateResult applyPatch(const std::string& table,
+                            const std::string& key_column,
+                            const std::string& key,
+                            const std::vector<std::string>& assignments,
+                            std::optional<int> expected_version);
+
+    DatabaseConnection& db_;
+    std::chrono::milliseconds timeout_;
+    std::chrono::steady_clock::time_point deadline_;
+    OperationError last_error_;
+    const char* operation_;             // public call in progress, for log records
+    std::unique_ptr<QueryWatchdog> watchdog_;
+    StatementObserver observer_;
 };
 
 #endif // DATABASE_OPERATIONS_H
\ No newline at end of file
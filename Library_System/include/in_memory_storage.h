@@ -0,0 +1,164 @@
+#ifndef IN_MEMORY_STORAGE_H
+#define IN_MEMORY_STORAGE_H
+
+#include "library_storage.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+// Server-less LibraryStorage with the same rules as borrow_book /
+// return_book (see borrowing_method.sql and returning_method.sql):
+//   - a book that is 'borrowed' cannot be borrowed again
+//   - a user can hold at most kMaxActiveLoans books
+//   - loans are due kLoanPeriodDays after the borrow date
+//   - books and users with borrow records cannot be deleted (foreign keys)
+// and with the table constraints from building_sql.sql:
+//   - books.status is 'available' or 'borrowed' (ENUM)
+//   - users.email is unique, compared case-insensitively like the default
+//     collation
+//
+// Locking is fine-grained: the hash indexes on qr_code / card_id are split
+// into independently locked shards, and every book and user has its own
+// mutex. Borrow and return lock exactly one user and one book, so requests
+// for unrelated books never contend.
+class InMemoryStorage : public LibraryStorage {
+public:
+    static constexpr int kMaxActiveLoans = 5;
+    static constexpr int kLoanPeriodDays = 14;
+
+    // Returns today's date as YYYY-MM-DD; replaceable for tests.
+    using DateSource = std::function<std::string()>;
+
+    explicit InMemoryStorage(std::size_t shard_count = 16);
+
+    void setDateSource(DateSource source);
+
+    // Book operations
+    bool createBook(const Book& book) override;
+    std::optional<Book> getBook(const std::string& qr_code) override;
+    std::unordered_map<std::string, std::optional<Book>>
+        getBooks(const std::vector<std::string>& qr_codes) override;
+    std::vector<Book> getAllBooks() override;
+    bool updateBook(const Book& book) override;
+    UpdateResult patchBook(const BookPatch& patch) override;
+    bool deleteBook(const std::string& qr_code) override;
+
+    // User operations
+    bool createUser(const User& user) override;
+    std::optional<User> getUser(const std::string& card_id) override;
+    std::unordered_map<std::string, std::optional<User>>
+        getUsers(const std::vector<std::string>& card_ids) override;
+    std::vector<User> getAllUsers() override;
+    bool updateUser(const User& user) override;
+    UpdateResult patchUser(const UserPatch& patch) override;
+    bool deleteUser(const std::string& card_id) override;
+
+    // Borrow record operations
+    bool createBorrowRecord(const std::string& book_qr, const std::string& user_card) override;
+    bool returnBook(const std::string& book_qr) override;
+    std::vector<BorrowRecord> getUserBorrowHistory(const std::string& user_card) override;
+    std::vector<BorrowRecord> getBookBorrowHistory(const std::string& book_qr) override;
+    std::optional<std::size_t> countUserLoans(const std::string& user_card, bool open_only) override;
+
+private:
+    // A record is shared by the book's and the user's history so a return
+    // is visible from both sides.
+    using RecordPtr = std::shared_ptr<BorrowRecord>;
+
+    struct BookEntry {
+        std::mutex mutex;
+        Book book;
+        std::vector<RecordPtr> history;   // oldest first
+        bool deleted = false;
+    };
+
+    struct UserEntry {
+        std::mutex mutex;
+        User user;
+        std::vector<RecordPtr> history;   // oldest first
+        int active_loans = 0;
+        bool deleted = false;
+    };
+
+    template <typename Key, typename Entry>
+    class ShardedIndex {
+    public:
+        explicit ShardedIndex(std::size_t shard_count) : shards_(shard_count) {}
+
+        std::shared_ptr<Entry> find(const Key& key) const {
+            const Shard& shard = shardFor(key);
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            auto it = shard.map.find(key);
+            return it == shard.map.end() ? nullptr : it->second;
+        }
+
+        bool insert(const Key& key, std::shared_ptr<Entry> entry) {
+            Shard& shard = shardFor(key);
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            return shard.map.emplace(key, std::move(entry)).second;
+        }
+
+        void erase(const Key& key) {
+            Shard& shard = shardFor(key);
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            shard.map.erase(key);
+        }
+
+        std::vector<std::shared_ptr<Entry>> values() const {
+            std::vector<std::shared_ptr<Entry>> result;
+            for (const Shard& shard : shards_) {
+                std::shared_lock<std::shared_mutex> lock(shard.mutex);
+                for (const auto& item : shard.map) {
+                    result.push_back(item.second);
+                }
+            }
+            return result;
+        }
+
+    private:
+        struct Shard {
+            mutable std::shared_mutex mutex;
+            std::unordered_map<Key, std::shared_ptr<Entry>> map;
+        };
+
+        const Shard& shardFor(const Key& key) const {
+            return shards_[std::hash<Key>{}(key) % shards_.size()];
+        }
+        Shard& shardFor(const Key& key) {
+            return shards_[std::hash<Key>{}(key) % shards_.size()];
+        }
+
+        std::vector<Shard> shards_;
+    };
+
+    static bool isBookStatus(const std::string& status);
+    // Claims `email` for user_id; false if another user already has it
+    bool claimEmail(const std::string& email, int user_id);
+    void releaseEmail(const std::string& email, int user_id);
+
+    std::string today() const;
+    static std::string addDays(const std::string& date, int days);
+    static std::vector<BorrowRecord> newestFirst(const std::vector<RecordPtr>& history);
+
+    ShardedIndex<std::string, BookEntry> books_;
+    ShardedIndex<std::string, UserEntry> users_;
+    ShardedIndex<int, UserEntry> users_by_id_;
+
+    std::atomic<int> next_book_id_{1};
+    std::atomic<int> next_user_id_{1};
+    std::atomic<int> next_record_id_{1};
+
+    // users.email UNIQUE: folded email -> user_id. Taken after a user's own
+    // mutex, never before it.
+    std::mutex email_mutex_;
+    std::unordered_map<std::string, int> emails_;
+
+    mutable std::mutex date_mutex_;
+    DateSource date_source_;
+};
+
+#endif // IN_MEMORY_STORAGE_H
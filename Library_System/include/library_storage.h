@@ -0,0 +1,151 @@
+#ifndef LIBRARY_STORAGE_H
+#define LIBRARY_STORAGE_H
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct Book {
+    int id;
+    std::string qr_code;
+    std::string title;
+    std::string author;
+    std::string isbn;
+    int publication_year;
+    std::string status;
+    int version = 0;            // bumped by every write to the row
+};
+
+struct User {
+    int id;
+    std::string card_id;
+    std::string name;
+    std::string email;
+    std::string phone;
+    int version = 0;
+};
+
+struct BorrowRecord {
+    int record_id;
+    int book_id;
+    int user_id;
+    std::string borrow_date;
+    std::string due_date;
+    std::optional<std::string> return_date;
+};
+
+// Partial update of one book: only the fields that are set are written.
+// With expected_version set the update is a compare-and-set against the
+// row's version and reports a conflict instead of overwriting a
+// concurrent edit.
+struct BookPatch {
+    std::string qr_code;
+    std::optional<std::string> title;
+    std::optional<std::string> author;
+    std::optional<std::string> isbn;
+    std::optional<int> publication_year;
+    std::optional<std::string> status;
+    std::optional<int> expected_version;
+
+    bool empty() const {
+        return !title && !author && !isbn && !publication_year && !status;
+    }
+
+    // Patch that turns `before` into `after`, conditional on before.version
+    static BookPatch diff(const Book& before, const Book& after) {
+        BookPatch patch;
+        patch.qr_code = before.qr_code;
+        if (after.title != before.title) patch.title = after.title;
+        if (after.author != before.author) patch.author = after.author;
+        if (after.isbn != before.isbn) patch.isbn = after.isbn;
+        if (after.publication_year != before.publication_year) patch.publication_year = after.publication_year;
+        if (after.status != before.status) patch.status = after.status;
+        patch.expected_version = before.version;
+        return patch;
+    }
+};
+
+struct UserPatch {
+    std::string card_id;
+    std::optional<std::string> name;
+    std::optional<std::string> email;
+    std::optional<std::string> phone;
+    std::optional<int> expected_version;
+
+    bool empty() const {
+        return !name && !email && !phone;
+    }
+
+    static UserPatch diff(const User& before, const User& after) {
+        UserPatch patch;
+        patch.card_id = before.card_id;
+        if (after.name != before.name) patch.name = after.name;
+        if (after.email != before.email) patch.email = after.email;
+        if (after.phone != before.phone) patch.phone = after.phone;
+        patch.expected_version = before.version;
+        return patch;
+    }
+};
+
+enum class UpdateResult {
+    Applied,        // written, or nothing to write
+    Conflict,       // expected_version did not match
+    NotFound,
+    Error,          // see the backend's own error reporting
+    Partial         // written to the primary copy but not to every replica
+};
+
+// Storage-independent library operations.
+//
+// DatabaseOperations implements this on top of MySQL and the stored
+// procedures; InMemoryStorage implements the same semantics without a
+// server. Code that only needs the operations should take a LibraryStorage&.
+class LibraryStorage {
+public:
+    virtual ~LibraryStorage() = default;
+
+    // Book operations
+    // Uses book.qr_code if set, otherwise assigns the next BOOKnnnnnnnn code.
+    virtual bool createBook(const Book& book) = 0;
+    virtual std::optional<Book> getBook(const std::string& qr_code) = 0;
+    // Looks up many books at once. Every requested qr_code appears in the
+    // result; codes that do not exist map to std::nullopt. If the lookup
+    // fails part way the result is empty, so a missing key is never
+    // mistaken for a missing book; DatabaseOperations reports the cause
+    // through lastError().
+    virtual std::unordered_map<std::string, std::optional<Book>>
+        getBooks(const std::vector<std::string>& qr_codes) = 0;
+    virtual std::vector<Book> getAllBooks() = 0;
+    // Rewrites every column, last writer wins
+    virtual bool updateBook(const Book& book) = 0;
+    // Writes only the fields set in the patch and bumps the version. An
+    // empty patch writes nothing but still reports NotFound or Conflict.
+    virtual UpdateResult patchBook(const BookPatch& patch) = 0;
+    virtual bool deleteBook(const std::string& qr_code) = 0;
+
+    // User operations
+    // Uses user.card_id if set, otherwise assigns the next USERnnnnnnnn code.
+    virtual bool createUser(const User& user) = 0;
+    virtual std::optional<User> getUser(const std::string& card_id) = 0;
+    // Same contract as getBooks
+    virtual std::unordered_map<std::string, std::optional<User>>
+        getUsers(const std::vector<std::string>& card_ids) = 0;
+    virtual std::vector<User> getAllUsers() = 0;
+    virtual bool updateUser(const User& user) = 0;
+    virtual UpdateResult patchUser(const UserPatch& patch) = 0;
+    virtual bool deleteUser(const std::string& card_id) = 0;
+
+    // Borrow record operations
+    virtual bool createBorrowRecord(const std::string& book_qr, const std::string& user_card) = 0;
+    virtual bool returnBook(const std::string& book_qr) = 0;
+    virtual std::vector<BorrowRecord> getUserBorrowHistory(const std::string& user_card) = 0;
+    virtual std::vector<BorrowRecord> getBookBorrowHistory(const std::string& book_qr) = 0;
+    // Number of the user's borrow records, or only those not returned yet
+    // when open_only is set; 0 for an unknown card. std::nullopt means the
+    // count could not be read, unlike an empty history.
+    virtual std::optional<std::size_t> countUserLoans(const std::string& user_card, bool open_only) = 0;
+};
+
+#endif // LIBRARY_STORAGE_H
@@ -0,0 +1,68 @@
+#ifndef PLAN_INSPECTOR_H
+#define PLAN_INSPECTOR_H
+
+#include <mysql/mysql.h>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct PlanFinding {
+    std::string statement_template;    // literals replaced by '?'
+    std::string sample;                 // one concrete statement that was issued
+    uint64_t executions = 0;
+    uint64_t failures = 0;              // executions that returned an error
+    double avg_rows_returned = 0.0;     // observed at run time, successful executions only
+    double rows_examined = 0.0;         // optimizer estimate from EXPLAIN
+    bool explained = false;             // false for CALL and other non-EXPLAIN-able statements
+    bool full_scan = false;             // access_type ALL or full index scan
+    bool filesort = false;
+    bool temporary_table = false;
+    std::vector<std::string> notes;     // e.g. "full scan on borrow_records"
+    std::string error;                  // EXPLAIN failure, if any
+
+    bool flagged() const { return full_scan || filesort || temporary_table; }
+    std::string flagString() const;     // "scan,filesort,temp" or "-"
+};
+
+// Collects the statements DatabaseOperations issues and explains them.
+//
+// Hook it up with
+//     ops.setStatementObserver([&](const std::string& q, uint64_t rows, bool ok) {
+//         inspector.record(q, rows, ok);
+//     });
+// run a representative workload, then call inspect() with a connection to
+// the same database. EXPLAIN does not execute the statement, so DML is safe
+// to inspect; the workload itself does execute, so run it in a transaction
+// that is rolled back afterwards.
+class PlanInspector {
+public:
+    void record(const std::string& query, uint64_t rows, bool ok = true);
+
+    std::vector<PlanFinding> inspect(MYSQL* conn);
+
+    // Baselines are text files with one line per template. A regression is
+    // a flag that the baseline did not have, or an estimate of rows
+    // examined that grew by more than `growth_factor`. compareBaseline()
+    // throws std::runtime_error if the baseline file cannot be read.
+    static bool writeBaseline(const std::string& path, const std::vector<PlanFinding>& findings);
+    static std::vector<std::string> compareBaseline(const std::string& path,
+                                                    const std::vector<PlanFinding>& findings,
+                                                    double growth_factor = 2.0);
+
+    static std::string normalize(const std::string& query);
+
+private:
+    struct Capture {
+        std::string sample;
+        uint64_t executions = 0;
+        uint64_t failures = 0;
+        uint64_t rows = 0;
+    };
+
+    std::mutex mutex_;
+    std::map<std::string, Capture> captures_;
+};
+
+#endif // PLAN_INSPECTOR_H
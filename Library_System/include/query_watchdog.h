@@ -0,0 +1,65 @@
+#ifndef QUERY_WATCHDOG_H
+#define QUERY_WATCHDOG_H
+
+#include "database.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <thread>
+
+// Cancels statements that run past their deadline.
+//
+// A caller arms the watchdog with the server thread id of the connection
+// that is about to run a statement, and disarms it when the statement
+// returns. If the deadline passes first, a background thread issues
+// KILL QUERY <id> from its own side connection; the blocked mysql_query()
+// then fails with ER_QUERY_INTERRUPTED and disarm() reports the kill.
+// The KILL is sent without holding the lock arm() and disarm() use, so a
+// slow server only delays the statement being killed.
+class QueryWatchdog {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit QueryWatchdog(DatabaseConnection& db);
+    ~QueryWatchdog();
+
+    QueryWatchdog(const QueryWatchdog&) = delete;
+    QueryWatchdog& operator=(const QueryWatchdog&) = delete;
+
+    // Opens the side connection ahead of the first deadline, so a kill does
+    // not also pay for a connect. Returns false if it could not be opened;
+    // the watchdog then retries when it needs to kill.
+    bool connect();
+
+    // Returns a ticket to pass to disarm()
+    uint64_t arm(unsigned long thread_id, Clock::time_point deadline);
+    // Returns true if the statement was killed because of its deadline
+    bool disarm(uint64_t ticket);
+
+private:
+    enum class State { Armed, Killing, Killed };
+
+    struct Watch {
+        unsigned long thread_id;
+        Clock::time_point deadline;
+        State state;
+    };
+
+    void run();
+    bool killQuery(unsigned long thread_id);
+
+    DatabaseConnection& db_;
+    std::mutex side_mutex_;             // guards side_connection_
+    MYSQL* side_connection_;
+
+    std::mutex mutex_;                  // guards watches_, next_ticket_, stopping_
+    std::condition_variable changed_;
+    std::map<uint64_t, Watch> watches_;
+    uint64_t next_ticket_;
+    bool stopping_;
+    std::thread thread_;
+};
+
+#endif // QUERY_WATCHDOG_H
@@ -0,0 +1,56 @@
+#ifndef RESHARDER_H
+#define RESHARDER_H
+
+#include "database.h"
+#include "sharded_operations.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct ReshardStats {
+    uint64_t users = 0;                     // distinct users copied to each target
+    uint64_t source_users = 0;              // distinct card_ids across the sources
+    std::vector<uint64_t> books;            // per target
+    std::vector<uint64_t> borrow_records;   // per target
+    uint64_t source_books = 0;
+    uint64_t source_borrow_records = 0;
+    bool verified = false;                  // every target has all users; books and
+                                            // records add up to the source counts
+    double seconds = 0.0;
+};
+
+// Copies a library from one set of instances to another under a new
+// routing, e.g. from a single server to N shards or from N to M shards.
+//
+// Every user is copied to every target. Each book is copied to the target
+// its router picks, followed by its borrow records in record_id order; the
+// records are re-linked to the target's book_id and user_id through
+// qr_code and card_id. Row versions are kept, so patches prepared against
+// the old layout still apply. Sources are only read, so cutover happens
+// after the copy has been verified.
+//
+// Targets must already have the schema and stored procedures, and must
+// not contain users, books or borrow records.
+class Resharder {
+public:
+    Resharder(std::vector<DatabaseConnection*> sources,
+              std::vector<DatabaseConnection*> targets,
+              const ShardRouter& router,
+              std::size_t batch_size = 1000);
+
+    // Throws std::runtime_error on database errors or non-empty targets
+    ReshardStats run();
+
+private:
+    void copyUsers(ReshardStats& stats);
+    void copyBooks(ReshardStats& stats);
+    void copyBorrowRecords(ReshardStats& stats);
+    void verify(ReshardStats& stats);
+
+    std::vector<DatabaseConnection*> sources_;
+    std::vector<DatabaseConnection*> targets_;
+    const ShardRouter& router_;
+    std::size_t batch_size_;
+};
+
+#endif // RESHARDER_H
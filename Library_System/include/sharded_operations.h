@@ -0,0 +1,131 @@
+#ifndef SHARDED_OPERATIONS_H
+#define SHARDED_OPERATIONS_H
+
+#include "library_storage.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Maps a book's qr_code to the shard that owns the book and its borrow
+// records.
+class ShardRouter {
+public:
+    virtual ~ShardRouter() = default;
+    virtual std::size_t shardCount() const = 0;
+    virtual std::size_t shardFor(const std::string& qr_code) const = 0;
+};
+
+// 64-bit FNV-1a of the key modulo the shard count. Adding a shard moves
+// most keys, so changing the count goes through Resharder.
+class HashShardRouter : public ShardRouter {
+public:
+    explicit HashShardRouter(std::size_t shard_count);
+
+    std::size_t shardCount() const override { return shard_count_; }
+    std::size_t shardFor(const std::string& qr_code) const override;
+
+    static uint64_t hash(const std::string& key);
+
+private:
+    std::size_t shard_count_;
+};
+
+// Routes by the longest registered prefix, e.g. a branch code such as
+// "TPE-", so that each branch catalog stays on one instance. Keys with no
+// registered prefix fall back to hash routing.
+class PrefixShardRouter : public ShardRouter {
+public:
+    explicit PrefixShardRouter(std::size_t shard_count);
+
+    void addPrefix(const std::string& prefix, std::size_t shard);
+
+    std::size_t shardCount() const override { return fallback_.shardCount(); }
+    std::size_t shardFor(const std::string& qr_code) const override;
+
+private:
+    std::vector<std::pair<std::string, std::size_t>> prefixes_;   // longest first
+    HashShardRouter fallback_;
+};
+
+// LibraryStorage over several independent backends, typically one
+// DatabaseOperations per MySQL instance.
+//
+// Books and their borrow records live on the shard chosen by the router,
+// so borrowing and returning stay single-instance transactions. Users are
+// replicated to every shard because the stored procedures and foreign keys
+// need a local users row. Cross-shard reads run on all shards in parallel
+// and are merged in the order a single instance would return:
+// getAllBooks by qr_code, getUserBorrowHistory by borrow_date descending.
+//
+// Differences from a single instance:
+//   - createBook/createUser need an explicit qr_code/card_id, because the
+//     per-instance BOOKnnnnnnnn sequence would collide across shards;
+//   - book_id, user_id and record_id are local to a shard;
+//   - user writes are applied shard by shard, not atomically; a failed
+//     createUser or deleteUser is undone on the shards that succeeded
+//     (a restored user starts over at version 0), and patchUser checks
+//     the version on shard 0 before touching the other replicas;
+//   - the five-loan limit is checked across shards before borrowing, but
+//     two concurrent borrows on different shards can both pass it;
+//   - checks that need every shard (the loan limit, deleteUser) fail
+//     closed: if any shard cannot answer, the operation is refused.
+class ShardedOperations : public LibraryStorage {
+public:
+    static constexpr std::size_t kMaxActiveLoans = 5;
+
+    // Throws std::invalid_argument if there are no shards or the router is
+    // configured for a different number of shards.
+    ShardedOperations(std::vector<std::unique_ptr<LibraryStorage>> shards,
+                      std::unique_ptr<ShardRouter> router);
+
+    std::size_t shardCount() const { return shards_.size(); }
+    const ShardRouter& router() const { return *router_; }
+    LibraryStorage& shard(std::size_t index) { return *shards_[index]; }
+
+    // Book operations
+    bool createBook(const Book& book) override;
+    std::optional<Book> getBook(const std::string& qr_code) override;
+    std::unordered_map<std::string, std::optional<Book>>
+        getBooks(const std::vector<std::string>& qr_codes) override;
+    std::vector<Book> getAllBooks() override;
+    bool updateBook(const Book& book) override;
+    UpdateResult patchBook(const BookPatch& patch) override;
+    bool deleteBook(const std::string& qr_code) override;
+
+    // User operations
+    bool createUser(const User& user) override;
+    std::optional<User> getUser(const std::string& card_id) override;
+    std::unordered_map<std::string, std::optional<User>>
+        getUsers(const std::vector<std::string>& card_ids) override;
+    std::vector<User> getAllUsers() override;
+    bool updateUser(const User& user) override;
+    // Compare-and-set on shard 0, then applied to the other replicas
+    // without a version condition; Partial if a replica was not updated
+    UpdateResult patchUser(const UserPatch& patch) override;
+    bool deleteUser(const std::string& card_id) override;
+
+    // Borrow record operations
+    bool createBorrowRecord(const std::string& book_qr, const std::string& user_card) override;
+    bool returnBook(const std::string& book_qr) override;
+    std::vector<BorrowRecord> getUserBorrowHistory(const std::string& user_card) override;
+    std::vector<BorrowRecord> getBookBorrowHistory(const std::string& book_qr) override;
+    std::optional<std::size_t> countUserLoans(const std::string& user_card, bool open_only) override;
+
+private:
+    // Calls fn(shard_index) for every shard concurrently and returns the
+    // results in shard order
+    template <typename Fn>
+    auto scatter(Fn fn) -> std::vector<decltype(fn(std::size_t{}))>;
+
+    LibraryStorage& bookShard(const std::string& qr_code);
+    // Any replica can serve a user read; spread them by card_id
+    LibraryStorage& userReplica(const std::string& card_id);
+
+    std::vector<std::unique_ptr<LibraryStorage>> shards_;
+    std::unique_ptr<ShardRouter> router_;
+};
+
+#endif // SHARDED_OPERATIONS_H
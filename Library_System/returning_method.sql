@@ -34,7 +34,8 @@ BEGIN
     ELSE
         START TRANSACTION;
         
-        -- 更新書籍狀態
+        -- 更新書籍狀態；version 由 after_return_update_stock trigger 遞增，
+        -- 這裡不再加一，避免一次還書被算成兩次寫入
         UPDATE books 
         SET status = 'available'
         WHERE qr_code = p_qr_code;
@@ -0,0 +1,258 @@
+#include "async_logger.h"
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+
+namespace {
+
+const char* levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::Debug:   return "DEBUG";
+        case LogLevel::Info:    return "INFO";
+        case LogLevel::Warning: return "WARN";
+        case LogLevel::Error:   return "ERROR";
+    }
+    return "?";
+}
+
+// 複製到固定長度的欄位，超過就截斷，結尾一定是 '\0'
+void copyField(char* dst, std::size_t capacity, const char* src, std::size_t length) {
+    std::size_t n = length < capacity - 1 ? length : capacity - 1;
+    std::memcpy(dst, src, n);
+    dst[n] = '\0';
+}
+
+} // namespace
+
+AsyncLogger& AsyncLogger::getInstance() {
+    static AsyncLogger instance;
+    return instance;
+}
+
+AsyncLogger::AsyncLogger()
+    : slots_(new Slot[kCapacity])
+    , enqueue_pos_(0)
+    , dequeue_pos_(0)
+    , level_(LogLevel::Info)
+    , enqueued_(0)
+    , dropped_(0)
+    , writer_idle_(false)
+    , burst_(5)
+    , window_(std::chrono::seconds(10))
+    , written_(0)
+    , stopping_(false)
+    , out_(&std::cerr) {
+    for (std::size_t i = 0; i < kCapacity; ++i) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    thread_ = std::thread(&AsyncLogger::run, this);
+}
+
+AsyncLogger::~AsyncLogger() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+void AsyncLogger::setRateLimit(unsigned int burst, std::chrono::milliseconds window) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    burst_ = burst;
+    window_ = window;
+}
+
+void AsyncLogger::setOutput(std::ostream& out) {
+    std::lock_guard<std::mutex> lock(io_mutex_);
+    out_->flush();
+    out_ = &out;
+}
+
+// 呼叫端只做：搶一個 slot、複製欄位、發布。不格式化、不碰 I/O、不拿鎖
+void AsyncLogger::log(LogLevel level, const char* operation, const std::string& message,
+                      unsigned int error_code, std::chrono::microseconds latency,
+                      const std::string& query) {
+    if (!enabled(level)) {
+        return;
+    }
+
+    Slot* slot;
+    std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+        slot = &slots_[pos & (kCapacity - 1)];
+        std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+        if (diff == 0) {
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // ring 滿了：寧可丟掉也不要讓查詢執行緒等待
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    LogRecord& record = slot->record;
+    record.level = level;
+    record.time = std::chrono::system_clock::now();
+    copyField(record.operation, sizeof(record.operation), operation, std::strlen(operation));
+    copyField(record.message, sizeof(record.message), message.data(), message.size());
+    copyField(record.query, sizeof(record.query), query.data(), query.size());
+    record.query_length = static_cast<uint32_t>(query.size());
+    record.error_code = error_code;
+    record.latency_us = static_cast<uint32_t>(latency.count());
+
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    enqueued_.fetch_add(1, std::memory_order_release);
+
+    if (writer_idle_.load()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wake_.notify_one();
+    }
+}
+
+void AsyncLogger::flush() {
+    uint64_t target = enqueued_.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> lock(mutex_);
+    wake_.notify_one();
+    written_cv_.wait(lock, [&] { return written_ >= target; });
+}
+
+bool AsyncLogger::tryPop(LogRecord& record) {
+    Slot& slot = slots_[dequeue_pos_ & (kCapacity - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1) {
+        return false;
+    }
+    record = slot.record;
+    slot.sequence.store(dequeue_pos_ + kCapacity, std::memory_order_release);
+    ++dequeue_pos_;
+    return true;
+}
+
+void AsyncLogger::run() {
+    std::vector<LogRecord> batch;
+    batch.reserve(kBatchSize);
+    LogRecord record;
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true) {
+        // 持有 mutex_ 時只做搬移：取出一批紀錄並複製設定
+        batch.clear();
+        while (batch.size() < kBatchSize && tryPop(record)) {
+            batch.push_back(record);
+        }
+        unsigned int burst = burst_;
+        std::chrono::milliseconds window = window_;
+        bool stopping = stopping_ && batch.empty();
+
+        // 格式化、寫入與 flush 都在放開 mutex_ 之後，producer 喚醒 writer 不會被 I/O 擋住
+        lock.unlock();
+        {
+            std::lock_guard<std::mutex> io_lock(io_mutex_);
+            auto now = std::chrono::steady_clock::now();
+            for (const auto& pending : batch) {
+                write(*out_, pending, burst, now);
+            }
+            bool reported = reportSuppressed(*out_, window, now, stopping);
+            if (!batch.empty() || reported || stopping) {
+                out_->flush();
+            }
+        }
+        lock.lock();
+
+        if (!batch.empty()) {
+            written_ += batch.size();
+            written_cv_.notify_all();
+            continue;
+        }
+        if (stopping) {
+            return;
+        }
+
+        // 先標記 idle 再檢查一次，避免漏掉剛發布的紀錄；逾時只是保險
+        writer_idle_.store(true);
+        Slot& next = slots_[dequeue_pos_ & (kCapacity - 1)];
+        if (!stopping_ && next.sequence.load() != dequeue_pos_ + 1) {
+            wake_.wait_for(lock, std::chrono::milliseconds(100));
+        }
+        writer_idle_.store(false);
+    }
+}
+
+// 同一個 (operation, error_code, level) 在一個 window 內最多寫 burst_ 行
+bool AsyncLogger::admit(const LogRecord& record, unsigned int burst,
+                        std::chrono::steady_clock::time_point now) {
+    if (record.level < LogLevel::Warning) {
+        return true;
+    }
+    RateWindow& window = windows_[std::make_tuple(std::string(record.operation),
+                                                  record.error_code, record.level)];
+    if (window.written == 0 && window.suppressed == 0) {
+        window.start = now;
+    }
+    if (window.written < burst) {
+        ++window.written;
+        return true;
+    }
+    ++window.suppressed;
+    return false;
+}
+
+bool AsyncLogger::reportSuppressed(std::ostream& out, std::chrono::milliseconds window,
+                                   std::chrono::steady_clock::time_point now, bool all) {
+    bool reported = false;
+    for (auto it = windows_.begin(); it != windows_.end();) {
+        if (!all && now - it->second.start < window) {
+            ++it;
+            continue;
+        }
+        if (it->second.suppressed > 0) {
+            out << levelName(std::get<2>(it->first)) << ' ' << std::get<0>(it->first)
+                << " err=" << std::get<1>(it->first)
+                << " suppressed " << it->second.suppressed << " similar messages\n";
+            reported = true;
+        }
+        it = windows_.erase(it);
+    }
+    return reported;
+}
+
+void AsyncLogger::write(std::ostream& out, const LogRecord& record, unsigned int burst,
+                        std::chrono::steady_clock::time_point now) {
+    if (!admit(record, burst, now)) {
+        return;
+    }
+
+    std::time_t seconds = std::chrono::system_clock::to_time_t(record.time);
+    auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(
+        record.time.time_since_epoch()).count() % 1000;
+    std::tm tm;
+    localtime_r(&seconds, &tm);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm);
+    char fraction[8];
+    std::snprintf(fraction, sizeof(fraction), ".%03d", static_cast<int>(millis));
+
+    out << stamp << fraction << ' ' << levelName(record.level) << ' ' << record.operation;
+    if (record.error_code != 0) {
+        out << " err=" << record.error_code;
+    }
+    if (record.latency_us != 0) {
+        out << " latency=" << record.latency_us << "us";
+    }
+    if (record.message[0] != '\0') {
+        out << ' ' << record.message;
+    }
+    if (record.query_length > 0) {
+        out << " | query: " << record.query;
+        if (record.query_length >= sizeof(record.query)) {
+            out << "... (" << record.query_length << " bytes)";
+        }
+    }
+    out << '\n';
+}
@@ -0,0 +1,502 @@
+#include "borrow_exporter.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <zlib.h>
+
+namespace {
+
+const char kMagic[4] = {'L', 'B', 'C', 'F'};
+const uint8_t kVersion = 1;
+
+// 查詢欄位順序與 schema() 一致
+const char* kExportQuery =
+    "SELECT br.record_id, br.book_id, br.user_id, "
+    "br.borrow_date, br.due_date, br.return_date, "
+    "b.qr_code, b.title, b.author, b.isbn, b.status, "
+    "u.card_id, u.name "
+    "FROM borrow_records br "
+    "JOIN books b ON br.book_id = b.book_id "
+    "JOIN users u ON br.user_id = u.user_id "
+    "ORDER BY br.record_id";
+
+constexpr std::size_t kIntColumns = 6;      // 欄位 0-5 為整數 / 日期
+constexpr std::size_t kColumnCount = 13;
+
+// ---- varint / zigzag ----
+
+void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+uint64_t getVarint(const std::string& in, std::size_t& pos) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (pos >= in.size()) {
+            throw std::runtime_error("Truncated varint in columnar file");
+        }
+        uint8_t byte = static_cast<uint8_t>(in[pos++]);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    throw std::runtime_error("Malformed varint in columnar file");
+}
+
+uint64_t zigzag(int64_t v) {
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+int64_t unzigzag(uint64_t v) {
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+void putString(std::string& out, const std::string& s) {
+    putVarint(out, s.size());
+    out += s;
+}
+
+std::string getString(const std::string& in, std::size_t& pos) {
+    uint64_t len = getVarint(in, pos);
+    if (len > in.size() - pos) {
+        throw std::runtime_error("Truncated string in columnar file");
+    }
+    std::string s = in.substr(pos, len);
+    pos += len;
+    return s;
+}
+
+// ---- dates ----
+
+// 距離 1970-01-01 的天數（proleptic Gregorian，Howard Hinnant 的 days_from_civil）
+int64_t daysFromCivil(int y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return static_cast<int64_t>(era) * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+int64_t parseDate(const char* s) {
+    int y = 0;
+    unsigned m = 0, d = 0;
+    if (std::sscanf(s, "%d-%u-%u", &y, &m, &d) != 3) {
+        return 0;
+    }
+    return daysFromCivil(y, m, d);
+}
+
+// ---- column encodings ----
+
+std::string encodeDelta(const std::vector<int64_t>& values, const std::vector<uint8_t>* present) {
+    std::string out;
+    if (present) {
+        std::string bitmap((values.size() + 7) / 8, '\0');
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            if ((*present)[i]) {
+                bitmap[i / 8] = static_cast<char>(bitmap[i / 8] | (1 << (i % 8)));
+            }
+        }
+        out += bitmap;
+    }
+    int64_t prev = 0;
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        if (present && !(*present)[i]) {
+            continue;
+        }
+        putVarint(out, zigzag(values[i] - prev));
+        prev = values[i];
+    }
+    return out;
+}
+
+std::string encodeDictionary(const std::vector<std::string>& values) {
+    std::unordered_map<std::string, uint64_t> ids;
+    std::vector<const std::string*> dictionary;
+    std::string indices;
+    for (const auto& value : values) {
+        auto it = ids.find(value);
+        if (it == ids.end()) {
+            it = ids.emplace(value, dictionary.size()).first;
+            dictionary.push_back(&it->first);
+        }
+        putVarint(indices, it->second);
+    }
+
+    std::string out;
+    putVarint(out, dictionary.size());
+    for (const auto* entry : dictionary) {
+        putString(out, *entry);
+    }
+    return out + indices;
+}
+
+std::string encodePlain(const std::vector<std::string>& values) {
+    std::string out;
+    for (const auto& value : values) {
+        putString(out, value);
+    }
+    return out;
+}
+
+std::string compress(const std::string& raw) {
+    uLongf size = compressBound(raw.size());
+    std::string out(size, '\0');
+    if (compress2(reinterpret_cast<Bytef*>(&out[0]), &size,
+                  reinterpret_cast<const Bytef*>(raw.data()), raw.size(),
+                  Z_BEST_SPEED) != Z_OK) {
+        throw std::runtime_error("zlib compression failed");
+    }
+    out.resize(size);
+    return out;
+}
+
+std::string decompress(const std::string& data, uint64_t raw_size) {
+    std::string out(raw_size, '\0');
+    uLongf size = raw_size;
+    if (uncompress(reinterpret_cast<Bytef*>(&out[0]), &size,
+                   reinterpret_cast<const Bytef*>(data.data()), data.size()) != Z_OK ||
+        size != raw_size) {
+        throw std::runtime_error("zlib decompression failed");
+    }
+    return out;
+}
+
+void putU32(std::string& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+    }
+}
+
+uint32_t getU32(const char* p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) {
+        v |= static_cast<uint32_t>(static_cast<uint8_t>(p[i])) << (8 * i);
+    }
+    return v;
+}
+
+// 一個 row group 的緩衝資料
+struct RowGroupBuffer {
+    std::vector<int64_t> ints[kIntColumns];
+    std::vector<uint8_t> return_present;
+    std::vector<std::string> strings[kColumnCount - kIntColumns];
+
+    std::size_t size() const { return ints[0].size(); }
+
+    void clear() {
+        for (auto& column : ints) column.clear();
+        return_present.clear();
+        for (auto& column : strings) column.clear();
+    }
+};
+
+struct MysqlCloser {
+    void operator()(MYSQL* conn) const { mysql_close(conn); }
+};
+
+} // namespace
+
+const std::vector<ColumnInfo>& BorrowRecordExporter::schema() {
+    static const std::vector<ColumnInfo> columns = {
+        {"record_id",   ColumnType::Int64,  ColumnEncoding::Delta,      false},
+        {"book_id",     ColumnType::Int64,  ColumnEncoding::Delta,      false},
+        {"user_id",     ColumnType::Int64,  ColumnEncoding::Delta,      false},
+        {"borrow_date", ColumnType::Date,   ColumnEncoding::Delta,      false},
+        {"due_date",    ColumnType::Date,   ColumnEncoding::Delta,      false},
+        {"return_date", ColumnType::Date,   ColumnEncoding::Delta,      true},
+        {"qr_code",     ColumnType::String, ColumnEncoding::Plain,      false},
+        {"title",       ColumnType::String, ColumnEncoding::Dictionary, false},
+        {"author",      ColumnType::String, ColumnEncoding::Dictionary, false},
+        {"isbn",        ColumnType::String, ColumnEncoding::Plain,      false},
+        {"status",      ColumnType::String, ColumnEncoding::Dictionary, false},
+        {"card_id",     ColumnType::String, ColumnEncoding::Plain,      false},
+        {"user_name",   ColumnType::String, ColumnEncoding::Dictionary, false},
+    };
+    return columns;
+}
+
+BorrowRecordExporter::BorrowRecordExporter(DatabaseConnection& db, std::size_t row_group_size)
+    : db_(db)
+    , row_group_size_(row_group_size == 0 ? 1 : row_group_size) {
+}
+
+ExportStats BorrowRecordExporter::exportTo(const std::string& path) {
+    auto start = std::chrono::steady_clock::now();
+    const auto& columns = schema();
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot open export file: " + path);
+    }
+
+    // 用獨立連線串流，匯出期間主連線仍可使用
+    std::unique_ptr<MYSQL, MysqlCloser> conn(db_.openSideConnection());
+    if (!conn) {
+        throw std::runtime_error("Cannot open export connection: " + db_.getLastError());
+    }
+    // mysql_use_result 期間伺服器要等我們讀完，壓縮一個 row group 的時間要算進去
+    if (mysql_query(conn.get(), "SET SESSION net_write_timeout = 600") != 0) {
+        throw std::runtime_error(std::string("Cannot set export write timeout: ") +
+                                 mysql_error(conn.get()));
+    }
+    if (mysql_query(conn.get(), kExportQuery) != 0) {
+        throw std::runtime_error(std::string("Export query failed: ") + mysql_error(conn.get()));
+    }
+    MYSQL_RES* result = mysql_use_result(conn.get());
+    if (!result) {
+        throw std::runtime_error(std::string("Export result failed: ") + mysql_error(conn.get()));
+    }
+    std::unique_ptr<MYSQL_RES, void (*)(MYSQL_RES*)> result_guard(result, mysql_free_result);
+
+    ExportStats stats;
+    uint64_t offset = 0;
+    auto write = [&](const std::string& bytes) {
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        offset += bytes.size();
+    };
+
+    std::string header(kMagic, sizeof(kMagic));
+    header.push_back(static_cast<char>(kVersion));
+    write(header);
+
+    std::vector<RowGroupInfo> row_groups;
+    RowGroupBuffer buffer;
+
+    auto flush = [&] {
+        if (buffer.size() == 0) {
+            return;
+        }
+        RowGroupInfo info;
+        info.row_count = buffer.size();
+        info.min_record_id = buffer.ints[0].front();
+        info.max_record_id = buffer.ints[0].back();
+
+        for (std::size_t c = 0; c < kColumnCount; ++c) {
+            std::string raw;
+            if (c < kIntColumns) {
+                raw = encodeDelta(buffer.ints[c], columns[c].nullable ? &buffer.return_present : nullptr);
+            } else if (columns[c].encoding == ColumnEncoding::Dictionary) {
+                raw = encodeDictionary(buffer.strings[c - kIntColumns]);
+            } else {
+                raw = encodePlain(buffer.strings[c - kIntColumns]);
+            }
+            std::string packed = compress(raw);
+            info.chunks.push_back(ColumnChunkInfo{offset, packed.size(), raw.size()});
+            write(packed);
+        }
+
+        row_groups.push_back(std::move(info));
+        buffer.clear();
+    };
+
+    MYSQL_ROW row;
+    while ((row = mysql_fetch_row(result))) {
+        buffer.ints[0].push_back(std::stoll(row[0]));
+        buffer.ints[1].push_back(row[1] ? std::stoll(row[1]) : 0);
+        buffer.ints[2].push_back(row[2] ? std::stoll(row[2]) : 0);
+        buffer.ints[3].push_back(row[3] ? parseDate(row[3]) : 0);
+        buffer.ints[4].push_back(row[4] ? parseDate(row[4]) : 0);
+        buffer.ints[5].push_back(row[5] ? parseDate(row[5]) : 0);
+        buffer.return_present.push_back(row[5] ? 1 : 0);
+        for (std::size_t c = kIntColumns; c < kColumnCount; ++c) {
+            buffer.strings[c - kIntColumns].emplace_back(row[c] ? row[c] : "");
+        }
+        ++stats.rows;
+
+        if (buffer.size() >= row_group_size_) {
+            flush();
+        }
+    }
+    // mysql_fetch_row 回傳 nullptr 可能是讀完，也可能是中途斷線
+    if (mysql_errno(conn.get()) != 0) {
+        throw std::runtime_error(std::string("Export stream failed: ") + mysql_error(conn.get()));
+    }
+    flush();
+
+    // footer
+    std::string footer;
+    putVarint(footer, columns.size());
+    for (const auto& column : columns) {
+        putString(footer, column.name);
+        footer.push_back(static_cast<char>(column.type));
+        footer.push_back(static_cast<char>(column.encoding));
+        footer.push_back(static_cast<char>(column.nullable ? 1 : 0));
+    }
+    putVarint(footer, row_groups.size());
+    for (const auto& group : row_groups) {
+        putVarint(footer, group.row_count);
+        putVarint(footer, zigzag(group.min_record_id));
+        putVarint(footer, zigzag(group.max_record_id));
+        for (const auto& chunk : group.chunks) {
+            putVarint(footer, chunk.offset);
+            putVarint(footer, chunk.compressed_size);
+            putVarint(footer, chunk.raw_size);
+        }
+    }
+    putU32(footer, static_cast<uint32_t>(footer.size()));
+    footer.append(kMagic, sizeof(kMagic));
+    write(footer);
+
+    out.flush();
+    if (!out) {
+        throw std::runtime_error("Write failed: " + path);
+    }
+
+    stats.row_groups = row_groups.size();
+    stats.bytes_written = offset;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+ColumnarReader::ColumnarReader(const std::string& path)
+    : in_(path, std::ios::binary) {
+    if (!in_) {
+        throw std::runtime_error("Cannot open columnar file: " + path);
+    }
+
+    in_.seekg(0, std::ios::end);
+    std::streamoff file_size = in_.tellg();
+    if (file_size < 13) {
+        throw std::runtime_error("Not a columnar export: " + path);
+    }
+
+    char trailer[8];
+    in_.seekg(file_size - 8);
+    in_.read(trailer, sizeof(trailer));
+    if (std::memcmp(trailer + 4, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("Not a columnar export: " + path);
+    }
+    uint32_t footer_size = getU32(trailer);
+    if (footer_size > file_size - 13) {
+        throw std::runtime_error("Corrupt footer in " + path);
+    }
+
+    std::string footer(footer_size, '\0');
+    in_.seekg(file_size - 8 - footer_size);
+    in_.read(&footer[0], footer_size);
+
+    std::size_t pos = 0;
+    uint64_t column_count = getVarint(footer, pos);
+    for (uint64_t i = 0; i < column_count; ++i) {
+        ColumnInfo column;
+        column.name = getString(footer, pos);
+        if (pos + 3 > footer.size()) {
+            throw std::runtime_error("Corrupt footer in " + path);
+        }
+        column.type = static_cast<ColumnType>(footer[pos++]);
+        column.encoding = static_cast<ColumnEncoding>(footer[pos++]);
+        column.nullable = footer[pos++] != 0;
+        columns_.push_back(column);
+    }
+    uint64_t group_count = getVarint(footer, pos);
+    for (uint64_t g = 0; g < group_count; ++g) {
+        RowGroupInfo group;
+        group.row_count = getVarint(footer, pos);
+        group.min_record_id = unzigzag(getVarint(footer, pos));
+        group.max_record_id = unzigzag(getVarint(footer, pos));
+        for (uint64_t c = 0; c < column_count; ++c) {
+            ColumnChunkInfo chunk;
+            chunk.offset = getVarint(footer, pos);
+            chunk.compressed_size = getVarint(footer, pos);
+            chunk.raw_size = getVarint(footer, pos);
+            group.chunks.push_back(chunk);
+        }
+        row_groups_.push_back(std::move(group));
+    }
+}
+
+int ColumnarReader::columnIndex(const std::string& name) const {
+    for (std::size_t i = 0; i < columns_.size(); ++i) {
+        if (columns_[i].name == name) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+std::string ColumnarReader::readChunk(std::size_t row_group, std::size_t column) {
+    const ColumnChunkInfo& chunk = row_groups_.at(row_group).chunks.at(column);
+    std::string packed(chunk.compressed_size, '\0');
+    in_.clear();
+    in_.seekg(static_cast<std::streamoff>(chunk.offset));
+    in_.read(&packed[0], static_cast<std::streamsize>(packed.size()));
+    if (!in_) {
+        throw std::runtime_error("Truncated column chunk");
+    }
+    return decompress(packed, chunk.raw_size);
+}
+
+std::vector<int64_t> ColumnarReader::readIntegers(std::size_t row_group, const std::string& column,
+                                                  std::vector<bool>* present) {
+    int index = columnIndex(column);
+    if (index < 0 || columns_[index].type == ColumnType::String) {
+        throw std::runtime_error("Not an integer column: " + column);
+    }
+    const ColumnInfo& info = columns_[index];
+    std::size_t rows = row_groups_.at(row_group).row_count;
+    std::string raw = readChunk(row_group, static_cast<std::size_t>(index));
+
+    std::size_t pos = 0;
+    std::vector<bool> flags(rows, true);
+    if (info.nullable) {
+        std::size_t bitmap_size = (rows + 7) / 8;
+        if (raw.size() < bitmap_size) {
+            throw std::runtime_error("Truncated null bitmap");
+        }
+        for (std::size_t i = 0; i < rows; ++i) {
+            flags[i] = (static_cast<uint8_t>(raw[i / 8]) >> (i % 8)) & 1;
+        }
+        pos = bitmap_size;
+    }
+
+    std::vector<int64_t> values(rows, 0);
+    int64_t prev = 0;
+    for (std::size_t i = 0; i < rows; ++i) {
+        if (!flags[i]) {
+            continue;
+        }
+        prev += unzigzag(getVarint(raw, pos));
+        values[i] = prev;
+    }
+    if (present) {
+        *present = std::move(flags);
+    }
+    return values;
+}
+
+std::vector<std::string> ColumnarReader::readStrings(std::size_t row_group, const std::string& column) {
+    int index = columnIndex(column);
+    if (index < 0 || columns_[index].type != ColumnType::String) {
+        throw std::runtime_error("Not a string column: " + column);
+    }
+    std::size_t rows = row_groups_.at(row_group).row_count;
+    std::string raw = readChunk(row_group, static_cast<std::size_t>(index));
+
+    std::size_t pos = 0;
+    std::vector<std::string> values;
+    values.reserve(rows);
+    if (columns_[index].encoding == ColumnEncoding::Dictionary) {
+        std::vector<std::string> dictionary(getVarint(raw, pos));
+        for (auto& entry : dictionary) {
+            entry = getString(raw, pos);
+        }
+        for (std::size_t i = 0; i < rows; ++i) {
+            values.push_back(dictionary.at(getVarint(raw, pos)));
+        }
+    } else {
+        for (std::size_t i = 0; i < rows; ++i) {
+            values.push_back(getString(raw, pos));
+        }
+    }
+    return values;
+}
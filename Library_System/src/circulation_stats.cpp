@@ -0,0 +1,421 @@
+#include "circulation_stats.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+struct MysqlCloser {
+    void operator()(MYSQL* conn) const { mysql_close(conn); }
+};
+using ConnectionPtr = std::unique_ptr<MYSQL, MysqlCloser>;
+
+struct ResultFree {
+    void operator()(MYSQL_RES* result) const { mysql_free_result(result); }
+};
+using ResultPtr = std::unique_ptr<MYSQL_RES, ResultFree>;
+
+ConnectionPtr openConnection(DatabaseConnection& db) {
+    ConnectionPtr conn(db.openSideConnection());
+    if (!conn) {
+        throw std::runtime_error("Cannot open statistics connection");
+    }
+    return conn;
+}
+
+// mysql_use_result：逐筆串流，不會把整個 partition 放進記憶體
+ResultPtr streamQuery(MYSQL* conn, const std::string& query) {
+    if (mysql_query(conn, query.c_str()) != 0) {
+        throw std::runtime_error(std::string("Statistics query failed: ") + mysql_error(conn));
+    }
+    ResultPtr result(mysql_use_result(conn));
+    if (!result) {
+        throw std::runtime_error(std::string("Statistics result failed: ") + mysql_error(conn));
+    }
+    return result;
+}
+
+void checkStreamEnd(MYSQL* conn) {
+    if (mysql_errno(conn) != 0) {
+        throw std::runtime_error(std::string("Statistics stream failed: ") + mysql_error(conn));
+    }
+}
+
+std::size_t latenessBucket(long long days_late) {
+    if (days_late <= 0) return 0;
+    if (days_late <= 3) return 1;
+    if (days_late <= 7) return 2;
+    if (days_late <= 14) return 3;
+    if (days_late <= 30) return 4;
+    return 5;
+}
+
+// 所有查詢都回傳相同欄位：
+// record_id, book_id, user_id, 借閱天數, 逾期天數, 是否未還, 是否已過期
+const char* kRecordColumns =
+    "SELECT record_id, book_id, user_id, "
+    "DATEDIFF(return_date, borrow_date), "
+    "DATEDIFF(return_date, due_date), "
+    "return_date IS NULL, "
+    "due_date < CURRENT_DATE "
+    "FROM borrow_records ";
+
+// 單一 worker 的區域彙總，最後再合併
+struct PartialStats {
+    uint64_t loans = 0;
+    uint64_t returned = 0;
+    uint64_t loan_days = 0;
+    std::array<uint64_t, kLatenessBuckets> lateness{};
+    std::unordered_map<int, uint64_t> loans_per_book;
+    std::unordered_map<int, PatronStats> patrons;
+    std::unordered_map<int, int> open_loans;
+    uint64_t overdue = 0;
+    std::vector<long long> record_ids;      // 新讀到的記錄，用來推進 watermark
+};
+
+// 已歸還的記錄計入借閱天數與逾期分布；未歸還的記錄留到下次再檢查
+void addReturned(PartialStats& stats, int user_id, long long loan_days, long long days_late) {
+    ++stats.returned;
+    stats.loan_days += static_cast<uint64_t>(std::max(0LL, loan_days));
+    ++stats.lateness[latenessBucket(days_late)];
+    if (days_late > 0) {
+        ++stats.patrons[user_id].late_returns;
+    }
+}
+
+// 讀取 watermark 還沒看過的記錄
+void scanNewRecords(MYSQL* conn, const std::string& where, PartialStats& stats) {
+    ResultPtr result = streamQuery(conn, kRecordColumns + ("WHERE " + where));
+
+    MYSQL_ROW row;
+    while ((row = mysql_fetch_row(result.get()))) {
+        int record_id = std::stoi(row[0]);
+        int book_id = row[1] ? std::stoi(row[1]) : 0;
+        int user_id = row[2] ? std::stoi(row[2]) : 0;
+
+        stats.record_ids.push_back(record_id);
+        ++stats.loans;
+        ++stats.loans_per_book[book_id];
+        ++stats.patrons[user_id].loans;
+
+        if (row[5] && row[5][0] == '1') {
+            stats.open_loans[record_id] = user_id;
+            stats.overdue += (row[6] && row[6][0] == '1');
+        } else {
+            addReturned(stats, user_id, row[3] ? std::stoll(row[3]) : 0, row[4] ? std::stoll(row[4]) : 0);
+        }
+    }
+    checkStreamEnd(conn);
+}
+
+void scanPartition(DatabaseConnection& db, long long low, long long high, PartialStats& stats) {
+    ConnectionPtr conn = openConnection(db);
+    std::ostringstream where;
+    where << "record_id > " << low << " AND record_id <= " << high;
+    scanNewRecords(conn.get(), where.str(), stats);
+}
+
+// 上次還沒歸還的記錄：這次若已歸還就補進統計，否則繼續留著
+void recheckOpenLoans(MYSQL* conn, const std::unordered_map<int, int>& open_loans, PartialStats& stats) {
+    std::vector<int> ids;
+    ids.reserve(open_loans.size());
+    for (const auto& entry : open_loans) {
+        ids.push_back(entry.first);
+    }
+
+    const std::size_t kChunk = 1000;
+    for (std::size_t start = 0; start < ids.size(); start += kChunk) {
+        std::ostringstream query;
+        query << kRecordColumns << "WHERE record_id IN (";
+        for (std::size_t i = start; i < std::min(ids.size(), start + kChunk); ++i) {
+            query << (i == start ? "" : ", ") << ids[i];
+        }
+        query << ")";
+
+        ResultPtr result = streamQuery(conn, query.str());
+        MYSQL_ROW row;
+        while ((row = mysql_fetch_row(result.get()))) {
+            int record_id = std::stoi(row[0]);
+            int user_id = row[2] ? std::stoi(row[2]) : 0;
+            if (row[5] && row[5][0] == '1') {
+                stats.open_loans[record_id] = user_id;
+                stats.overdue += (row[6] && row[6][0] == '1');
+            } else {
+                addReturned(stats, user_id, row[3] ? std::stoll(row[3]) : 0, row[4] ? std::stoll(row[4]) : 0);
+            }
+        }
+        checkStreamEnd(conn);
+    }
+}
+
+std::unordered_map<int, std::string> lookupNames(MYSQL* conn, const std::string& select,
+                                                 const std::vector<int>& ids) {
+    std::unordered_map<int, std::string> names;
+    if (ids.empty()) {
+        return names;
+    }
+    std::ostringstream query;
+    query << select << " IN (";
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        query << (i == 0 ? "" : ", ") << ids[i];
+    }
+    query << ")";
+
+    ResultPtr result = streamQuery(conn, query.str());
+    MYSQL_ROW row;
+    while ((row = mysql_fetch_row(result.get()))) {
+        names[std::stoi(row[0])] = row[1] ? row[1] : "";
+    }
+    checkStreamEnd(conn);
+    return names;
+}
+
+} // namespace
+
+bool CirculationState::load(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+
+    CirculationState loaded;
+    long long high_water_mark = 0;
+    std::vector<IdWatermark::Gap> gaps;
+    std::string tag;
+    while (in >> tag) {
+        if (tag == "hwm") {
+            in >> high_water_mark;
+        } else if (tag == "gap") {
+            IdWatermark::Gap gap;
+            in >> gap.first >> gap.last >> gap.opened_at;
+            gaps.push_back(gap);
+        } else if (tag == "totals") {
+            in >> loaded.total_loans >> loaded.returned_loans >> loaded.total_loan_days;
+        } else if (tag == "lateness") {
+            for (auto& bucket : loaded.lateness) {
+                in >> bucket;
+            }
+        } else if (tag == "book") {
+            int id;
+            uint64_t loans;
+            in >> id >> loans;
+            loaded.loans_per_book[id] = loans;
+        } else if (tag == "patron") {
+            int id;
+            PatronStats patron;
+            in >> id >> patron.loans >> patron.late_returns;
+            loaded.patrons[id] = patron;
+        } else if (tag == "open") {
+            int record_id, user_id;
+            in >> record_id >> user_id;
+            loaded.open_loans[record_id] = user_id;
+        } else {
+            return false;
+        }
+        if (!in) {
+            return false;
+        }
+    }
+
+    // 舊版狀態檔沒有 gap 行，視為沒有待補的記錄
+    loaded.watermark.restore(high_water_mark, std::move(gaps));
+    *this = std::move(loaded);
+    return true;
+}
+
+bool CirculationState::save(const std::string& path) const {
+    // 先寫暫存檔再改名，中途失敗不會破壞上一次的狀態
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        out << "hwm " << watermark.highWater() << "\n";
+        for (const auto& gap : watermark.gaps()) {
+            out << "gap " << gap.first << " " << gap.last << " " << gap.opened_at << "\n";
+        }
+        out << "totals " << total_loans << " " << returned_loans << " " << total_loan_days << "\n";
+        out << "lateness";
+        for (auto bucket : lateness) {
+            out << " " << bucket;
+        }
+        out << "\n";
+        for (const auto& entry : loans_per_book) {
+            out << "book " << entry.first << " " << entry.second << "\n";
+        }
+        for (const auto& entry : patrons) {
+            out << "patron " << entry.first << " " << entry.second.loans << " "
+                << entry.second.late_returns << "\n";
+        }
+        for (const auto& entry : open_loans) {
+            out << "open " << entry.first << " " << entry.second << "\n";
+        }
+        if (!out.flush()) {
+            return false;
+        }
+    }
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+CirculationStats::CirculationStats(DatabaseConnection& db, std::size_t workers,
+                                   long long gap_window, long long max_gap_age)
+    : db_(db)
+    , workers_(workers == 0 ? 1 : workers)
+    , gap_window_(gap_window < 0 ? 0 : gap_window)
+    , max_gap_age_(max_gap_age < 0 ? 0 : max_gap_age) {
+}
+
+CirculationReport CirculationStats::run(CirculationState& state, std::size_t top_n) {
+    auto start = std::chrono::steady_clock::now();
+    ConnectionPtr control = openConnection(db_);
+
+    // 1. 決定這次要掃描的範圍 (high_water_mark, new_high]
+    const long long high_water_mark = state.watermark.highWater();
+    long long new_high = high_water_mark;
+    {
+        ResultPtr result = streamQuery(control.get(), "SELECT COALESCE(MAX(record_id), 0) FROM borrow_records");
+        MYSQL_ROW row = mysql_fetch_row(result.get());
+        if (row && row[0]) {
+            new_high = std::max(new_high, std::stoll(row[0]));
+        }
+        while (mysql_fetch_row(result.get())) {
+        }
+    }
+
+    // 2. 平均切成 workers_ 段，每段一條連線平行掃描
+    long long range = new_high - high_water_mark;
+    std::size_t partitions = range > 0
+        ? static_cast<std::size_t>(std::min<long long>(static_cast<long long>(workers_), range))
+        : 0;
+    // 最後兩個分別給 gap 重讀與 open loans 重新檢查
+    const std::size_t gap_slot = partitions;
+    const std::size_t recheck_slot = partitions + 1;
+    std::vector<PartialStats> partials(partitions + 2);
+    std::vector<std::exception_ptr> errors(partitions);
+    std::vector<std::thread> threads;
+    for (std::size_t p = 0; p < partitions; ++p) {
+        long long low = high_water_mark + range * static_cast<long long>(p) / static_cast<long long>(partitions);
+        long long high = high_water_mark + range * static_cast<long long>(p + 1) / static_cast<long long>(partitions);
+        threads.emplace_back([this, low, high, p, &partials, &errors] {
+            try {
+                scanPartition(db_, low, high, partials[p]);
+            } catch (...) {
+                errors[p] = std::current_exception();
+            }
+        });
+    }
+
+    // 掃描進行時，控制連線順便重讀 gap 內晚 commit 的記錄，並檢查上次未歸還的記錄
+    std::exception_ptr recheck_error;
+    try {
+        std::string gaps = state.watermark.gapCondition("record_id");
+        if (!gaps.empty()) {
+            scanNewRecords(control.get(), gaps, partials[gap_slot]);
+        }
+        recheckOpenLoans(control.get(), state.open_loans, partials[recheck_slot]);
+    } catch (...) {
+        recheck_error = std::current_exception();
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    if (recheck_error) {
+        std::rethrow_exception(recheck_error);
+    }
+
+    // 3. 合併到新的 state（全部成功才覆蓋呼叫端的 state）
+    //    new_high 以下還沒 commit 的記錄由 watermark 記成 gap，下次再讀
+    CirculationState next = state;
+    next.open_loans.clear();
+    uint64_t overdue = 0;
+    uint64_t scanned = 0;
+    std::vector<long long> seen;
+    for (std::size_t p = 0; p < partials.size(); ++p) {
+        const PartialStats& partial = partials[p];
+        if (p != recheck_slot) {
+            scanned += partial.loans;
+            seen.insert(seen.end(), partial.record_ids.begin(), partial.record_ids.end());
+        }
+        next.total_loans += partial.loans;
+        next.returned_loans += partial.returned;
+        next.total_loan_days += partial.loan_days;
+        for (std::size_t b = 0; b < kLatenessBuckets; ++b) {
+            next.lateness[b] += partial.lateness[b];
+        }
+        for (const auto& entry : partial.loans_per_book) {
+            next.loans_per_book[entry.first] += entry.second;
+        }
+        for (const auto& entry : partial.patrons) {
+            PatronStats& patron = next.patrons[entry.first];
+            patron.loans += entry.second.loans;
+            patron.late_returns += entry.second.late_returns;
+        }
+        next.open_loans.insert(partial.open_loans.begin(), partial.open_loans.end());
+        overdue += partial.overdue;
+    }
+    long long now = static_cast<long long>(std::time(nullptr));
+    next.watermark.advance(std::move(seen), now);
+    next.watermark.expire(now, max_gap_age_, gap_window_);
+
+    // 4. 產生報表
+    CirculationReport report;
+    report.total_loans = next.total_loans;
+    report.returned_loans = next.returned_loans;
+    report.open_loans = next.open_loans.size();
+    report.overdue_loans = overdue;
+    report.average_loan_days = next.returned_loans > 0
+        ? static_cast<double>(next.total_loan_days) / next.returned_loans
+        : 0.0;
+    report.lateness = next.lateness;
+    report.scanned_records = scanned;
+
+    std::vector<std::pair<int, uint64_t>> books(next.loans_per_book.begin(), next.loans_per_book.end());
+    std::size_t book_count = std::min(top_n, books.size());
+    std::partial_sort(books.begin(), books.begin() + book_count, books.end(),
+                      [](const auto& a, const auto& b) {
+                          return a.second != b.second ? a.second > b.second : a.first < b.first;
+                      });
+    books.resize(book_count);
+
+    std::vector<std::pair<int, PatronStats>> patrons(next.patrons.begin(), next.patrons.end());
+    std::size_t patron_count = std::min(top_n, patrons.size());
+    std::partial_sort(patrons.begin(), patrons.begin() + patron_count, patrons.end(),
+                      [](const auto& a, const auto& b) {
+                          return a.second.loans != b.second.loans ? a.second.loans > b.second.loans
+                                                                  : a.first < b.first;
+                      });
+    patrons.resize(patron_count);
+
+    // 只查前 N 名的書名與卡號
+    std::vector<int> book_ids, user_ids;
+    for (const auto& entry : books) book_ids.push_back(entry.first);
+    for (const auto& entry : patrons) user_ids.push_back(entry.first);
+    auto titles = lookupNames(control.get(), "SELECT book_id, title FROM books WHERE book_id", book_ids);
+    auto cards = lookupNames(control.get(), "SELECT user_id, card_id FROM users WHERE user_id", user_ids);
+
+    for (const auto& entry : books) {
+        report.top_titles.push_back(TitleCount{entry.first, titles[entry.first], entry.second});
+    }
+    for (const auto& entry : patrons) {
+        report.top_patrons.push_back(PatronActivity{entry.first, cards[entry.first],
+                                                    entry.second.loans, entry.second.late_returns});
+    }
+
+    state = std::move(next);
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
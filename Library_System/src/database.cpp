@@ -1,6 +1,22 @@
 #include "database.h"
 #include <stdexcept>
 
+namespace {
+
+void applyTimeouts(MYSQL* conn, const ConnectionTimeouts& timeouts) {
+    if (timeouts.connect_seconds > 0) {
+        mysql_options(conn, MYSQL_OPT_CONNECT_TIMEOUT, &timeouts.connect_seconds);
+    }
+    if (timeouts.read_seconds > 0) {
+        mysql_options(conn, MYSQL_OPT_READ_TIMEOUT, &timeouts.read_seconds);
+    }
+    if (timeouts.write_seconds > 0) {
+        mysql_options(conn, MYSQL_OPT_WRITE_TIMEOUT, &timeouts.write_seconds);
+    }
+}
+
+} // namespace
+
 std::unique_ptr<DatabaseConnection> DatabaseConnection::instance_ = nullptr;
 
 DatabaseConnection::DatabaseConnection(const std::string& host,
@@ -36,6 +52,15 @@ void DatabaseConnection::initialize(const std::string& host,
     }
 }
 
+std::unique_ptr<DatabaseConnection> DatabaseConnection::create(const std::string& host,
+                                                              const std::string& user,
+                                                              const std::string& password,
+                                                              const std::string& database,
+                                                              unsigned int port) {
+    return std::unique_ptr<DatabaseConnection>(
+        new DatabaseConnection(host, user, password, database, port));
+}
+
 DatabaseConnection& DatabaseConnection::getInstance() {
     if (!instance_) {
         throw std::runtime_error("Database not initialized. Call initialize() first.");
@@ -44,6 +69,8 @@ DatabaseConnection& DatabaseConnection::getInstance() {
 }
 
 bool DatabaseConnection::connect() {
+    // timeout 必須在 mysql_real_connect 之前設定
+    applyTimeouts(connection_, timeouts_);
     if (!mysql_real_connect(connection_, 
                           host_.c_str(),
                           user_.c_str(),
@@ -64,6 +91,30 @@ void DatabaseConnection::disconnect() {
     }
 }
 
+MYSQL* DatabaseConnection::openSideConnection() const {
+    MYSQL* conn = mysql_init(nullptr);
+    if (!conn) {
+        return nullptr;
+    }
+    applyTimeouts(conn, timeouts_);
+    if (!mysql_real_connect(conn,
+                          host_.c_str(),
+                          user_.c_str(),
+                          password_.c_str(),
+                          database_.c_str(),
+                          port_,
+                          nullptr,
+                          0)) {
+        mysql_close(conn);
+        return nullptr;
+    }
+    return conn;
+}
+
+unsigned long DatabaseConnection::getThreadId() const {
+    return mysql_thread_id(connection_);
+}
+
 bool DatabaseConnection::isConnected() const {
     return mysql_ping(connection_) == 0;
 }
@@ -1,42 +1,219 @@
 // database_operations.cpp
 #include "database_operation.h"
-#include <iostream>
+#include "async_logger.h"
 #include <sstream>
 
-bool DatabaseOperations::executeQuery(const std::string& query) {
-    DatabaseConnection& db = DatabaseConnection::getInstance();
-    MYSQL* conn = db.getRawConnection();
+namespace {
+
+// mysqld_error.h / errmsg.h
+constexpr unsigned int kErQueryInterrupted = 1317;
+constexpr unsigned int kErQueryTimeout = 3024;      // MAX_EXECUTION_TIME exceeded
+constexpr unsigned int kCrServerLost = 2013;        // read/write timeout
+
+// 只有 SELECT 能用 MAX_EXECUTION_TIME hint，讓伺服器自己中止查詢
+std::string withExecutionLimit(const std::string& query, long long millis) {
+    if (query.compare(0, 7, "SELECT ") != 0) {
+        return query;
+    }
+    return "SELECT /*+ MAX_EXECUTION_TIME(" + std::to_string(millis) + ") */ " + query.substr(7);
+}
+
+// 明確列出欄位，不受 created_at 等欄位順序影響
+const char* const kBookColumns = "book_id, qr_code, title, author, isbn, publication_year, status, version";
+const char* const kUserColumns = "user_id, card_id, name, email, phone, version";
+
+std::string field(const char* value) {
+    return value ? value : "";
+}
+
+// 欄位順序同 kBookColumns
+Book parseBook(MYSQL_ROW row) {
+    Book book;
+    book.id = std::stoi(row[0]);
+    book.qr_code = field(row[1]);
+    book.title = field(row[2]);
+    book.author = field(row[3]);
+    book.isbn = field(row[4]);
+    book.publication_year = row[5] ? std::stoi(row[5]) : 0;
+    book.status = field(row[6]);
+    book.version = row[7] ? std::stoi(row[7]) : 0;
+    return book;
+}
+
+// 欄位順序同 kUserColumns
+User parseUser(MYSQL_ROW row) {
+    User user;
+    user.id = std::stoi(row[0]);
+    user.card_id = field(row[1]);
+    user.name = field(row[2]);
+    user.email = field(row[3]);
+    user.phone = field(row[4]);
+    user.version = row[5] ? std::stoi(row[5]) : 0;
+    return user;
+}
+
+// 預設的 utf8mb4 collation 不分大小寫，'book00000001' 也會查到 BOOK00000001；
+// 回傳的列依折疊後的 key 對回呼叫端實際傳入的每一個 key
+std::string foldKey(const std::string& key) {
+    std::string folded(key);
+    for (char& c : folded) {
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+    }
+    return folded;
+}
+
+} // namespace
+
+DatabaseOperations::DatabaseOperations()
+    : DatabaseOperations(DatabaseConnection::getInstance()) {
+}
+
+DatabaseOperations::DatabaseOperations(DatabaseConnection& db)
+    : db_(db)
+    , timeout_(0)
+    , deadline_(std::chrono::steady_clock::time_point::max())
+    , last_error_(OperationError::None)
+    , operation_("") {
+}
+
+DatabaseOperations::~DatabaseOperations() = default;
+
+void DatabaseOperations::setOperationTimeout(std::chrono::milliseconds timeout) {
+    timeout_ = timeout;
+    if (timeout_.count() > 0 && !watchdog_) {
+        watchdog_ = std::make_unique<QueryWatchdog>(db_);
+        // 先建立 side connection，逾時的當下不必再花時間連線
+        if (!watchdog_->connect()) {
+            AsyncLogger::getInstance().log(LogLevel::Warning, "setOperationTimeout",
+                                           "Watchdog side connection unavailable; will retry on first kill");
+        }
+    }
+}
+
+// 每個 public 函式開頭呼叫，重設錯誤狀態並計算這次操作的 deadline
+void DatabaseOperations::beginOperation(const char* operation) {
+    operation_ = operation;
+    last_error_ = OperationError::None;
+    deadline_ = timeout_.count() > 0
+        ? std::chrono::steady_clock::now() + timeout_
+        : std::chrono::steady_clock::time_point::max();
+}
+
+bool DatabaseOperations::ensureConnection() {
+    MYSQL* conn = db_.getRawConnection();
     
     // 檢查連接狀態
     if (mysql_ping(conn) != 0) {
-        std::cerr << "Connection lost. Attempting to reconnect..." << std::endl;
-        if (!db.connect()) {
-            std::cerr << "Reconnection failed: " << mysql_error(conn) << std::endl;
+        AsyncLogger& logger = AsyncLogger::getInstance();
+        logger.log(LogLevel::Warning, operation_, "Connection lost. Attempting to reconnect...",
+                   mysql_errno(conn));
+        if (!db_.connect()) {
+            logger.log(LogLevel::Error, operation_, "Reconnection failed: " + db_.getLastError());
+            last_error_ = OperationError::Connection;
             return false;
         }
     }
+    return true;
+}
+
+// 執行單一語句；有 deadline 時由 watchdog 在逾時後送出 KILL QUERY
+bool DatabaseOperations::runStatement(MYSQL* conn, const std::string& query) {
+    AsyncLogger& logger = AsyncLogger::getInstance();
+    auto started = std::chrono::steady_clock::now();
+    auto elapsed = [&] {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - started);
+    };
 
-    if (mysql_query(conn, query.c_str()) != 0) {
-        std::cerr << "SQL Error: " << mysql_error(conn) << std::endl;
-        std::cerr << "Query was: " << query << std::endl;
+    if (deadline_ == std::chrono::steady_clock::time_point::max()) {
+        if (mysql_query(conn, query.c_str()) != 0) {
+            last_error_ = OperationError::Query;
+            logger.log(LogLevel::Error, operation_, mysql_error(conn), mysql_errno(conn),
+                       elapsed(), query);
+            return false;
+        }
+        if (logger.enabled(LogLevel::Debug)) {
+            logger.log(LogLevel::Debug, operation_, "", 0, elapsed(), query);
+        }
+        return true;
+    }
+
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline_ - started);
+    if (remaining.count() <= 0) {
+        last_error_ = OperationError::Timeout;
+        abandonTransaction(conn);
         return false;
     }
-    return true;
+
+    std::string limited = withExecutionLimit(query, remaining.count());
+    uint64_t ticket = watchdog_->arm(mysql_thread_id(conn), deadline_);
+    int rc = mysql_query(conn, limited.c_str());
+    bool killed = watchdog_->disarm(ticket);
+    if (rc == 0) {
+        if (logger.enabled(LogLevel::Debug)) {
+            logger.log(LogLevel::Debug, operation_, "", 0, elapsed(), query);
+        }
+        return true;
+    }
+
+    unsigned int err = mysql_errno(conn);
+    if (killed || err == kErQueryInterrupted || err == kErQueryTimeout ||
+        (err == kCrServerLost && std::chrono::steady_clock::now() >= deadline_)) {
+        last_error_ = OperationError::Timeout;
+        logger.log(LogLevel::Warning, operation_,
+                   "Query timed out after " + std::to_string(timeout_.count()) + " ms",
+                   err, elapsed(), query);
+        abandonTransaction(conn);
+    } else {
+        last_error_ = OperationError::Query;
+        logger.log(LogLevel::Error, operation_, mysql_error(conn), err, elapsed(), query);
+    }
+    return false;
+}
+
+// KILL QUERY 與 MAX_EXECUTION_TIME 只中止當下的語句，呼叫端開的交易和鎖都還在；
+// 回滾後確認連線上已沒有交易，不行就重設 session，最後才斷線讓伺服器回滾
+void DatabaseOperations::abandonTransaction(MYSQL* conn) {
+    AsyncLogger& logger = AsyncLogger::getInstance();
+    if (mysql_query(conn, "ROLLBACK") == 0 && !(conn->server_status & SERVER_STATUS_IN_TRANS)) {
+        return;
+    }
+    logger.log(LogLevel::Warning, operation_, "Rollback after timeout failed, resetting session",
+               mysql_errno(conn));
+    if (mysql_reset_connection(conn) == 0 && !(conn->server_status & SERVER_STATUS_IN_TRANS)) {
+        return;
+    }
+    // 下一次 ensureConnection() 會重新連線
+    logger.log(LogLevel::Error, operation_, "Session reset failed, dropping connection",
+               mysql_errno(conn));
+    db_.disconnect();
+}
+
+bool DatabaseOperations::executeQuery(const std::string& query) {
+    if (!ensureConnection()) {
+        return false;
+    }
+    MYSQL* conn = db_.getRawConnection();
+    bool ok = runStatement(conn, query);
+    if (observer_) {
+        observer_(query, ok ? mysql_affected_rows(conn) : 0, ok);
+    }
+    return ok;
 }
 
 MYSQL_RES* DatabaseOperations::executeSelectQuery(const std::string& query) {
-    
-    DatabaseConnection& db = DatabaseConnection::getInstance();
-    MYSQL* conn = db.getRawConnection();
-    
-    // 檢查連接狀態
-    if (mysql_ping(conn) != 0) {
-        std::cerr << "Connection lost. Attempting to reconnect..." << std::endl;
-        if (!db.connect()) {
-            std::cerr << "Reconnection failed: " << mysql_error(conn) << std::endl;
-            return nullptr;
-        }
+    if (!ensureConnection()) {
+        return nullptr;
     }
+    return runSelectQuery(query);
+}
+
+// 不做 mysql_ping，給已經確認過連線的批次查詢使用
+MYSQL_RES* DatabaseOperations::runSelectQuery(const std::string& query) {
+    MYSQL* conn = db_.getRawConnection();
     
     // 先清除任何之前的結果集
     while (mysql_next_result(conn) == 0) {
@@ -46,33 +223,135 @@ MYSQL_RES* DatabaseOperations::executeSelectQuery(const std::string& query) {
         }
     }
     
-    // 執行查詢
-    if (mysql_query(conn, query.c_str()) != 0) {
-        std::cerr << "SQL Error: " << mysql_error(conn) << std::endl;
-        std::cerr << "Query was: " << query << std::endl;
+    // 執行查詢；失敗的語句也通知 observer，逾時或出錯的查詢正是最需要看執行計畫的
+    if (!runStatement(conn, query)) {
+        if (observer_) {
+            observer_(query, 0, false);
+        }
         return nullptr;
     }
     
     MYSQL_RES* result = mysql_store_result(conn);
     if (!result) {
-        std::cerr << "Failed to store result: " << mysql_error(conn) << std::endl;
+        last_error_ = OperationError::Query;
+        AsyncLogger::getInstance().log(LogLevel::Error, operation_,
+                                       std::string("Failed to store result: ") + mysql_error(conn),
+                                       mysql_errno(conn), std::chrono::microseconds(0), query);
+    }
+    if (observer_) {
+        observer_(query, result ? mysql_num_rows(result) : 0, result != nullptr);
     }
     
     return result;
 }
 
+// 把 keys 切成多個 "prefix IN ('k1', 'k2', ...)" 查詢，每個查詢的 key 數量與長度都有上限
+std::vector<std::string> DatabaseOperations::buildInQueries(const std::string& prefix,
+                                                            const std::vector<std::string>& keys) {
+    std::vector<std::string> queries;
+    std::string query;
+    std::size_t count = 0;
+
+    for (const auto& key : keys) {
+        std::string literal = "'" + escapeString(key) + "'";
+        if (count > 0 && (count >= kMaxKeysPerBatch ||
+                          query.size() + literal.size() + 3 > kMaxBatchQueryBytes)) {
+            query += ")";
+            queries.push_back(std::move(query));
+            query.clear();
+            count = 0;
+        }
+        query += (count == 0) ? prefix + " IN (" : ", ";
+        query += literal;
+        ++count;
+    }
+    if (count > 0) {
+        query += ")";
+        queries.push_back(std::move(query));
+    }
+    return queries;
+}
+
 std::string DatabaseOperations::escapeString(const std::string& str) {
-    DatabaseConnection& db = DatabaseConnection::getInstance();
     char* escaped = new char[str.length() * 2 + 1];
-    mysql_real_escape_string(db.getRawConnection(), escaped, str.c_str(), str.length());
+    mysql_real_escape_string(db_.getRawConnection(), escaped, str.c_str(), str.length());
     std::string result(escaped);
     delete[] escaped;
     return result;
 }
 
+// 只更新有變動的欄位並遞增 version；有 expected_version 時是 compare-and-set，
+// 不符合就回報 Conflict，不會等待或覆蓋別人的修改
+UpdateResult DatabaseOperations::applyPatch(const std::string& table,
+                                            const std::string& key_column,
+                                            const std::string& key,
+                                            const std::vector<std::string>& assignments,
+                                            std::optional<int> expected_version) {
+    std::string where = " WHERE " + key_column + " = '" + escapeString(key) + "'";
+    if (assignments.empty()) {
+        // 空的 patch 不寫入也不遞增 version，但仍要回報資料不存在或 version 不符
+        MYSQL_RES* result = executeSelectQuery("SELECT version FROM " + table + where);
+        if (!result) {
+            return UpdateResult::Error;
+        }
+        MYSQL_ROW row = mysql_fetch_row(result);
+        std::optional<int> version;
+        if (row) {
+            version = row[0] ? std::stoi(row[0]) : 0;
+        }
+        mysql_free_result(result);
+        if (!version) {
+            return UpdateResult::NotFound;
+        }
+        return expected_version && *expected_version != *version ? UpdateResult::Conflict
+                                                                 : UpdateResult::Applied;
+    }
+
+    std::stringstream ss;
+    ss << "UPDATE " << table << " SET ";
+    for (const auto& assignment : assignments) {
+        ss << assignment << ", ";
+    }
+    ss << "version = version + 1" << where;
+    if (expected_version) {
+        ss << " AND version = " << *expected_version;
+    }
+
+    if (!executeQuery(ss.str())) {
+        return UpdateResult::Error;
+    }
+    // version 一定會變，所以只要條件成立 affected rows 就是 1
+    if (mysql_affected_rows(db_.getRawConnection()) > 0) {
+        return UpdateResult::Applied;
+    }
+    if (!expected_version) {
+        return UpdateResult::NotFound;
+    }
+
+    // 沒有更新到：分辨是資料不存在還是 version 不符
+    MYSQL_RES* result = runSelectQuery("SELECT version FROM " + table + where);
+    if (!result) {
+        return UpdateResult::Error;
+    }
+    bool exists = mysql_fetch_row(result) != nullptr;
+    mysql_free_result(result);
+    return exists ? UpdateResult::Conflict : UpdateResult::NotFound;
+}
+
 // Book Operations
 bool DatabaseOperations::createBook(const Book& book) {
+    beginOperation(__func__);
     std::stringstream ss;
+    if (!book.qr_code.empty()) {
+        // 呼叫端指定 qr_code（例如分片部署時由分館前綴或全域編號產生）
+        ss << "INSERT INTO books (title, author, isbn, publication_year, qr_code) VALUES ("
+           << "'" << escapeString(book.title) << "', "
+           << "'" << escapeString(book.author) << "', "
+           << "'" << escapeString(book.isbn) << "', "
+           << book.publication_year << ", "
+           << "'" << escapeString(book.qr_code) << "')";
+        return executeQuery(ss.str());
+    }
     ss << "INSERT INTO books (title, author, isbn, publication_year, qr_code) "  // 加入 qr_code 欄位
        << "SELECT "
        << "'" << escapeString(book.title) << "', "
@@ -85,7 +364,9 @@ bool DatabaseOperations::createBook(const Book& book) {
 }
 
 std::optional<Book> DatabaseOperations::getBook(const std::string& qr_code) {
-    std::string query = "SELECT * FROM books WHERE qr_code = '" + escapeString(qr_code) + "'";
+    beginOperation(__func__);
+    std::string query = std::string("SELECT ") + kBookColumns +
+                        " FROM books WHERE qr_code = '" + escapeString(qr_code) + "'";
     MYSQL_RES* result = executeSelectQuery(query);
     
     if (!result) {
@@ -98,22 +379,62 @@ std::optional<Book> DatabaseOperations::getBook(const std::string& qr_code) {
         return std::nullopt;
     }
     
-    Book book;
-    book.id = std::stoi(row[0]);
-    book.qr_code = row[1];
-    book.title = row[2];
-    book.author = row[3];
-    book.isbn = row[4];
-    book.publication_year = std::stoi(row[5]);
-    book.status = row[6];
+    Book book = parseBook(row);
     
     mysql_free_result(result);
     return book;
 }
 
+std::unordered_map<std::string, std::optional<Book>>
+DatabaseOperations::getBooks(const std::vector<std::string>& qr_codes) {
+    beginOperation(__func__);
+    std::unordered_map<std::string, std::optional<Book>> books;
+    std::unordered_map<std::string, std::vector<std::string>> requested;   // 折疊後的 key -> 原本的 key
+    for (const auto& qr_code : qr_codes) {
+        if (books.emplace(qr_code, std::nullopt).second) {  // 預設為找不到，同時去除重複的 key
+            requested[foldKey(qr_code)].push_back(qr_code);
+        }
+    }
+    if (books.empty()) {
+        return books;
+    }
+    if (!ensureConnection()) {
+        return {};
+    }
+
+    std::vector<std::string> keys;
+    keys.reserve(books.size());
+    for (const auto& entry : books) {
+        keys.push_back(entry.first);
+    }
+
+    // 整批只 ping 一次，每個 chunk 一次 round trip；
+    // 任何一個 chunk 失敗就整批失敗，不能讓查不到的 key 看起來像不存在
+    const std::string prefix = std::string("SELECT ") + kBookColumns + " FROM books WHERE qr_code";
+    for (const auto& query : buildInQueries(prefix, keys)) {
+        MYSQL_RES* result = runSelectQuery(query);
+        if (!result) {
+            return {};
+        }
+        MYSQL_ROW row;
+        while ((row = mysql_fetch_row(result))) {
+            Book book = parseBook(row);
+            auto it = requested.find(foldKey(book.qr_code));
+            if (it != requested.end()) {
+                for (const auto& key : it->second) {
+                    books[key] = book;
+                }
+            }
+        }
+        mysql_free_result(result);
+    }
+    return books;
+}
+
 std::vector<Book> DatabaseOperations::getAllBooks() {
+    beginOperation(__func__);
     std::vector<Book> books;
-    MYSQL_RES* result = executeSelectQuery("SELECT * FROM books");
+    MYSQL_RES* result = executeSelectQuery(std::string("SELECT ") + kBookColumns + " FROM books");
     
     if (!result) {
         return books;
@@ -121,15 +442,7 @@ std::vector<Book> DatabaseOperations::getAllBooks() {
     
     MYSQL_ROW row;
     while ((row = mysql_fetch_row(result))) {
-        Book book;
-        book.id = std::stoi(row[0]);
-        book.qr_code = row[1];
-        book.title = row[2];
-        book.author = row[3];
-        book.isbn = row[4];
-        book.publication_year = std::stoi(row[5]);
-        book.status = row[6];
-        books.push_back(book);
+        books.push_back(parseBook(row));
     }
     
     mysql_free_result(result);
@@ -137,25 +450,41 @@ std::vector<Book> DatabaseOperations::getAllBooks() {
 }
 
 bool DatabaseOperations::updateBook(const Book& book) {
+    beginOperation(__func__);
     std::stringstream ss;
     ss << "UPDATE books SET "
        << "title = '" << escapeString(book.title) << "', "
        << "author = '" << escapeString(book.author) << "', "
        << "isbn = '" << escapeString(book.isbn) << "', "
        << "publication_year = " << book.publication_year << ", "
-       << "status = '" << escapeString(book.status) << "' "
+       << "status = '" << escapeString(book.status) << "', "
+       << "version = version + 1 "
        << "WHERE qr_code = '" << escapeString(book.qr_code) << "'";
     
     return executeQuery(ss.str());
 }
 
+UpdateResult DatabaseOperations::patchBook(const BookPatch& patch) {
+    beginOperation(__func__);
+    std::vector<std::string> assignments;
+    if (patch.title) assignments.push_back("title = '" + escapeString(*patch.title) + "'");
+    if (patch.author) assignments.push_back("author = '" + escapeString(*patch.author) + "'");
+    if (patch.isbn) assignments.push_back("isbn = '" + escapeString(*patch.isbn) + "'");
+    if (patch.publication_year) assignments.push_back("publication_year = " + std::to_string(*patch.publication_year));
+    if (patch.status) assignments.push_back("status = '" + escapeString(*patch.status) + "'");
+
+    return applyPatch("books", "qr_code", patch.qr_code, assignments, patch.expected_version);
+}
+
 bool DatabaseOperations::deleteBook(const std::string& qr_code) {
+    beginOperation(__func__);
     std::string query = "DELETE FROM books WHERE qr_code = '" + escapeString(qr_code) + "'";
     return executeQuery(query);
 }
 
 // Borrow Operations
 bool DatabaseOperations::createBorrowRecord(const std::string& book_qr, const std::string& user_card) {
+    beginOperation(__func__);
     
     // 1. 先執行 procedure
     std::stringstream ss;
@@ -183,7 +512,16 @@ bool DatabaseOperations::createBorrowRecord(const std::string& book_qr, const st
 
 // User Operations
 bool DatabaseOperations::createUser(const User& user) {
+    beginOperation(__func__);
     std::stringstream ss;
+    if (!user.card_id.empty()) {
+        ss << "INSERT INTO users (name, email, phone, card_id) VALUES ("
+           << "'" << escapeString(user.name) << "', "
+           << "'" << escapeString(user.email) << "', "
+           << "'" << escapeString(user.phone) << "', "
+           << "'" << escapeString(user.card_id) << "')";
+        return executeQuery(ss.str());
+    }
     ss << "INSERT INTO users (name, email, phone, card_id) "  
        << "SELECT "
        << "'" << escapeString(user.name) << "', "
@@ -195,7 +533,9 @@ bool DatabaseOperations::createUser(const User& user) {
 }
 
 std::optional<User> DatabaseOperations::getUser(const std::string& card_id) {
-    std::string query = "SELECT * FROM users WHERE card_id = '" + escapeString(card_id) + "'";
+    beginOperation(__func__);
+    std::string query = std::string("SELECT ") + kUserColumns +
+                        " FROM users WHERE card_id = '" + escapeString(card_id) + "'";
     MYSQL_RES* result = executeSelectQuery(query);
     
     if (!result) {
@@ -208,20 +548,60 @@ std::optional<User> DatabaseOperations::getUser(const std::string& card_id) {
         return std::nullopt;
     }
     
-    User user;
-    user.id = std::stoi(row[0]);
-    user.card_id = row[1];
-    user.name = row[2];
-    user.email = row[3];
-    user.phone = row[4];
+    User user = parseUser(row);
     
     mysql_free_result(result);
     return user;
 }
 
+std::unordered_map<std::string, std::optional<User>>
+DatabaseOperations::getUsers(const std::vector<std::string>& card_ids) {
+    beginOperation(__func__);
+    std::unordered_map<std::string, std::optional<User>> users;
+    std::unordered_map<std::string, std::vector<std::string>> requested;
+    for (const auto& card_id : card_ids) {
+        if (users.emplace(card_id, std::nullopt).second) {
+            requested[foldKey(card_id)].push_back(card_id);
+        }
+    }
+    if (users.empty()) {
+        return users;
+    }
+    if (!ensureConnection()) {
+        return {};
+    }
+
+    std::vector<std::string> keys;
+    keys.reserve(users.size());
+    for (const auto& entry : users) {
+        keys.push_back(entry.first);
+    }
+
+    const std::string prefix = std::string("SELECT ") + kUserColumns + " FROM users WHERE card_id";
+    for (const auto& query : buildInQueries(prefix, keys)) {
+        MYSQL_RES* result = runSelectQuery(query);
+        if (!result) {
+            return {};
+        }
+        MYSQL_ROW row;
+        while ((row = mysql_fetch_row(result))) {
+            User user = parseUser(row);
+            auto it = requested.find(foldKey(user.card_id));
+            if (it != requested.end()) {
+                for (const auto& key : it->second) {
+                    users[key] = user;
+                }
+            }
+        }
+        mysql_free_result(result);
+    }
+    return users;
+}
+
 std::vector<User> DatabaseOperations::getAllUsers() {
+    beginOperation(__func__);
     std::vector<User> users;
-    MYSQL_RES* result = executeSelectQuery("SELECT * FROM users");
+    MYSQL_RES* result = executeSelectQuery(std::string("SELECT ") + kUserColumns + " FROM users");
     
     if (!result) {
         return users;
@@ -229,13 +609,7 @@ std::vector<User> DatabaseOperations::getAllUsers() {
     
     MYSQL_ROW row;
     while ((row = mysql_fetch_row(result))) {
-        User user;
-        user.id = std::stoi(row[0]);
-        user.card_id = row[1];
-        user.name = row[2];
-        user.email = row[3];
-        user.phone = row[4];
-        users.push_back(user);
+        users.push_back(parseUser(row));
     }
     
     mysql_free_result(result);
@@ -243,22 +617,36 @@ std::vector<User> DatabaseOperations::getAllUsers() {
 }
 
 bool DatabaseOperations::updateUser(const User& user) {
+    beginOperation(__func__);
     std::stringstream ss;
     ss << "UPDATE users SET "
        << "name = '" << escapeString(user.name) << "', "
        << "email = '" << escapeString(user.email) << "', "
-       << "phone = '" << escapeString(user.phone) << "' "
+       << "phone = '" << escapeString(user.phone) << "', "
+       << "version = version + 1 "
        << "WHERE card_id = '" << escapeString(user.card_id) << "'";
     
     return executeQuery(ss.str());
 }
 
+UpdateResult DatabaseOperations::patchUser(const UserPatch& patch) {
+    beginOperation(__func__);
+    std::vector<std::string> assignments;
+    if (patch.name) assignments.push_back("name = '" + escapeString(*patch.name) + "'");
+    if (patch.email) assignments.push_back("email = '" + escapeString(*patch.email) + "'");
+    if (patch.phone) assignments.push_back("phone = '" + escapeString(*patch.phone) + "'");
+
+    return applyPatch("users", "card_id", patch.card_id, assignments, patch.expected_version);
+}
+
 bool DatabaseOperations::deleteUser(const std::string& card_id) {
+    beginOperation(__func__);
     std::string query = "DELETE FROM users WHERE card_id = '" + escapeString(card_id) + "'";
     return executeQuery(query);
 }
 
 bool DatabaseOperations::returnBook(const std::string& book_qr) {
+    beginOperation(__func__);
     
     // 1. 執行 return_book procedure
     std::stringstream ss;
@@ -283,6 +671,7 @@ bool DatabaseOperations::returnBook(const std::string& book_qr) {
 }
 
 std::vector<BorrowRecord> DatabaseOperations::getUserBorrowHistory(const std::string& user_card) {
+    beginOperation(__func__);
     std::vector<BorrowRecord> records;
     std::string query = 
         "SELECT br.* FROM borrow_records br "
@@ -313,6 +702,7 @@ std::vector<BorrowRecord> DatabaseOperations::getUserBorrowHistory(const std::st
 }
 
 std::vector<BorrowRecord> DatabaseOperations::getBookBorrowHistory(const std::string& book_qr) {
+    beginOperation(__func__);
     std::vector<BorrowRecord> records;
     std::string query = 
         "SELECT br.* FROM borrow_records br "
@@ -340,4 +730,24 @@ std::vector<BorrowRecord> DatabaseOperations::getBookBorrowHistory(const std::st
     
     mysql_free_result(result);
     return records;
-}
\ No newline at end of file
+}
+std::optional<std::size_t> DatabaseOperations::countUserLoans(const std::string& user_card, bool open_only) {
+    beginOperation(__func__);
+    std::string query =
+        "SELECT COUNT(*) FROM borrow_records br "
+        "JOIN users u ON br.user_id = u.user_id "
+        "WHERE u.card_id = '" + escapeString(user_card) + "'";
+    if (open_only) {
+        query += " AND br.return_date IS NULL";
+    }
+
+    MYSQL_RES* result = executeSelectQuery(query);
+    if (!result) {
+        return std::nullopt;
+    }
+
+    MYSQL_ROW row = mysql_fetch_row(result);
+    std::size_t count = (row && row[0]) ? std::stoull(row[0]) : 0;
+    mysql_free_result(result);
+    return count;
+}
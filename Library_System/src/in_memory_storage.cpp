@@ -0,0 +1,448 @@
+#include "in_memory_storage.h"
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <sstream>
+#include <iomanip>
+
+namespace {
+
+// 與資料庫相同的編號格式：CONCAT(prefix, LPAD(id, 8, '0'))
+std::string makeCode(const char* prefix, int id) {
+    std::ostringstream ss;
+    ss << prefix << std::setw(8) << std::setfill('0') << id;
+    return ss.str();
+}
+
+std::string formatDate(const std::tm& tm) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%04d-%02d-%02d",
+                  tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+    return buf;
+}
+
+// 預設 collation 不分大小寫，UNIQUE 比對也是
+std::string foldEmail(const std::string& email) {
+    std::string folded(email);
+    for (char& c : folded) {
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+    }
+    return folded;
+}
+
+} // namespace
+
+InMemoryStorage::InMemoryStorage(std::size_t shard_count)
+    : books_(shard_count == 0 ? 1 : shard_count)
+    , users_(shard_count == 0 ? 1 : shard_count)
+    , users_by_id_(shard_count == 0 ? 1 : shard_count) {
+}
+
+void InMemoryStorage::setDateSource(DateSource source) {
+    std::lock_guard<std::mutex> lock(date_mutex_);
+    date_source_ = std::move(source);
+}
+
+std::string InMemoryStorage::today() const {
+    {
+        std::lock_guard<std::mutex> lock(date_mutex_);
+        if (date_source_) {
+            return date_source_();
+        }
+    }
+    std::time_t now = std::time(nullptr);
+    std::tm tm{};
+    localtime_r(&now, &tm);
+    return formatDate(tm);
+}
+
+std::string InMemoryStorage::addDays(const std::string& date, int days) {
+    std::tm tm{};
+    std::sscanf(date.c_str(), "%d-%d-%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday);
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    tm.tm_mday += days;
+    tm.tm_hour = 12;  // 避開日光節約時間的邊界
+    std::mktime(&tm);
+    return formatDate(tm);
+}
+
+bool InMemoryStorage::isBookStatus(const std::string& status) {
+    return status == "available" || status == "borrowed";
+}
+
+bool InMemoryStorage::claimEmail(const std::string& email, int user_id) {
+    std::lock_guard<std::mutex> lock(email_mutex_);
+    auto result = emails_.emplace(foldEmail(email), user_id);
+    return result.second || result.first->second == user_id;
+}
+
+void InMemoryStorage::releaseEmail(const std::string& email, int user_id) {
+    std::lock_guard<std::mutex> lock(email_mutex_);
+    auto it = emails_.find(foldEmail(email));
+    if (it != emails_.end() && it->second == user_id) {
+        emails_.erase(it);
+    }
+}
+
+std::vector<BorrowRecord> InMemoryStorage::newestFirst(const std::vector<RecordPtr>& history) {
+    // 等同 ORDER BY borrow_date DESC；同一天的記錄以較新的在前
+    std::vector<BorrowRecord> records;
+    records.reserve(history.size());
+    for (auto it = history.rbegin(); it != history.rend(); ++it) {
+        records.push_back(**it);
+    }
+    std::stable_sort(records.begin(), records.end(),
+                     [](const BorrowRecord& a, const BorrowRecord& b) {
+                         return a.borrow_date > b.borrow_date;
+                     });
+    return records;
+}
+
+// Book Operations
+bool InMemoryStorage::createBook(const Book& book) {
+    auto entry = std::make_shared<BookEntry>();
+    entry->book = book;
+    entry->book.id = next_book_id_++;
+    if (book.qr_code.empty()) {
+        entry->book.qr_code = makeCode("BOOK", entry->book.id);
+    }
+    entry->book.status = "available";  // 與 INSERT 未指定 status 時的預設值相同
+    entry->book.version = 0;
+    return books_.insert(entry->book.qr_code, entry);
+}
+
+std::optional<Book> InMemoryStorage::getBook(const std::string& qr_code) {
+    auto entry = books_.find(qr_code);
+    if (!entry) {
+        return std::nullopt;
+    }
+    std::lock_guard<std::mutex> lock(entry->mutex);
+    if (entry->deleted) {
+        return std::nullopt;
+    }
+    return entry->book;
+}
+
+std::unordered_map<std::string, std::optional<Book>>
+InMemoryStorage::getBooks(const std::vector<std::string>& qr_codes) {
+    std::unordered_map<std::string, std::optional<Book>> books;
+    for (const auto& qr_code : qr_codes) {
+        if (books.find(qr_code) == books.end()) {
+            books.emplace(qr_code, getBook(qr_code));
+        }
+    }
+    return books;
+}
+
+std::vector<Book> InMemoryStorage::getAllBooks() {
+    std::vector<Book> books;
+    for (const auto& entry : books_.values()) {
+        std::lock_guard<std::mutex> lock(entry->mutex);
+        if (!entry->deleted) {
+            books.push_back(entry->book);
+        }
+    }
+    std::sort(books.begin(), books.end(),
+              [](const Book& a, const Book& b) { return a.id < b.id; });
+    return books;
+}
+
+bool InMemoryStorage::updateBook(const Book& book) {
+    auto entry = books_.find(book.qr_code);
+    if (!entry) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(entry->mutex);
+    if (entry->deleted) {
+        return false;
+    }
+    if (!isBookStatus(book.status)) {
+        return false;  // ENUM 以外的值資料庫會拒絕
+    }
+    entry->book.title = book.title;
+    entry->book.author = book.author;
+    entry->book.isbn = book.isbn;
+    entry->book.publication_year = book.publication_year;
+    entry->book.status = book.status;
+    ++entry->book.version;
+    return true;
+}
+
+UpdateResult InMemoryStorage::patchBook(const BookPatch& patch) {
+    auto entry = books_.find(patch.qr_code);
+    if (!entry) {
+        return UpdateResult::NotFound;
+    }
+    std::lock_guard<std::mutex> lock(entry->mutex);
+    if (entry->deleted) {
+        return UpdateResult::NotFound;
+    }
+    if (patch.expected_version && *patch.expected_version != entry->book.version) {
+        return UpdateResult::Conflict;
+    }
+    if (patch.empty()) {
+        return UpdateResult::Applied;  // 沒有要寫的欄位：確認過存在與 version 後不遞增
+    }
+    if (patch.status && !isBookStatus(*patch.status)) {
+        return UpdateResult::Error;
+    }
+    if (patch.title) entry->book.title = *patch.title;
+    if (patch.author) entry->book.author = *patch.author;
+    if (patch.isbn) entry->book.isbn = *patch.isbn;
+    if (patch.publication_year) entry->book.publication_year = *patch.publication_year;
+    if (patch.status) entry->book.status = *patch.status;
+    ++entry->book.version;
+    return UpdateResult::Applied;
+}
+
+bool InMemoryStorage::deleteBook(const std::string& qr_code) {
+    auto entry = books_.find(qr_code);
+    if (!entry) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(entry->mutex);
+    // borrow_records 有外鍵指向 books，有借閱記錄的書不能刪
+    if (entry->deleted || !entry->history.empty()) {
+        return false;
+    }
+    entry->deleted = true;
+    books_.erase(qr_code);
+    return true;
+}
+
+// User Operations
+bool InMemoryStorage::createUser(const User& user) {
+    auto entry = std::make_shared<UserEntry>();
+    entry->user = user;
+    entry->user.id = next_user_id_++;
+    entry->user.version = 0;
+    if (user.card_id.empty()) {
+        entry->user.card_id = makeCode("USER", entry->user.id);
+    }
+    if (!claimEmail(entry->user.email, entry->user.id)) {
+        return false;
+    }
+    if (!users_.insert(entry->user.card_id, entry)) {
+        releaseEmail(entry->user.email, entry->user.id);
+        return false;
+    }
+    users_by_id_.insert(entry->user.id, entry);
+    return true;
+}
+
+std::optional<User> InMemoryStorage::getUser(const std::string& card_id) {
+    auto entry = users_.find(card_id);
+    if (!entry) {
+        return std::nullopt;
+    }
+    std::lock_guard<std::mutex> lock(entry->mutex);
+    if (entry->deleted) {
+        return std::nullopt;
+    }
+    return entry->user;
+}
+
+std::unordered_map<std::string, std::optional<User>>
+InMemoryStorage::getUsers(const std::vector<std::string>& card_ids) {
+    std::unordered_map<std::string, std::optional<User>> users;
+    for (const auto& card_id : card_ids) {
+        if (users.find(card_id) == users.end()) {
+            users.emplace(card_id, getUser(card_id));
+        }
+    }
+    return users;
+}
+
+std::vector<User> InMemoryStorage::getAllUsers() {
+    std::vector<User> users;
+    for (const auto& entry : users_.values()) {
+        std::lock_guard<std::mutex> lock(entry->mutex);
+        if (!entry->deleted) {
+            users.push_back(entry->user);
+        }
+    }
+    std::sort(users.begin(), users.end(),
+              [](const User& a, const User& b) { return a.id < b.id; });
+    return users;
+}
+
+bool InMemoryStorage::updateUser(const User& user) {
+    auto entry = users_.find(user.card_id);
+    if (!entry) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(entry->mutex);
+    if (entry->deleted) {
+        return false;
+    }
+    if (!claimEmail(user.email, entry->user.id)) {
+        return false;
+    }
+    if (foldEmail(user.email) != foldEmail(entry->user.email)) {
+        releaseEmail(entry->user.email, entry->user.id);
+    }
+    entry->user.name = user.name;
+    entry->user.email = user.email;
+    entry->user.phone = user.phone;
+    ++entry->user.version;
+    return true;
+}
+
+UpdateResult InMemoryStorage::patchUser(const UserPatch& patch) {
+    auto entry = users_.find(patch.card_id);
+    if (!entry) {
+        return UpdateResult::NotFound;
+    }
+    std::lock_guard<std::mutex> lock(entry->mutex);
+    if (entry->deleted) {
+        return UpdateResult::NotFound;
+    }
+    if (patch.expected_version && *patch.expected_version != entry->user.version) {
+        return UpdateResult::Conflict;
+    }
+    if (patch.empty()) {
+        return UpdateResult::Applied;
+    }
+    if (patch.email) {
+        if (!claimEmail(*patch.email, entry->user.id)) {
+            return UpdateResult::Error;  // 與資料庫相同：違反 UNIQUE
+        }
+        if (foldEmail(*patch.email) != foldEmail(entry->user.email)) {
+            releaseEmail(entry->user.email, entry->user.id);
+        }
+    }
+    if (patch.name) entry->user.name = *patch.name;
+    if (patch.email) entry->user.email = *patch.email;
+    if (patch.phone) entry->user.phone = *patch.phone;
+    ++entry->user.version;
+    return UpdateResult::Applied;
+}
+
+bool InMemoryStorage::deleteUser(const std::string& card_id) {
+    auto entry = users_.find(card_id);
+    if (!entry) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(entry->mutex);
+    if (entry->deleted || !entry->history.empty()) {
+        return false;
+    }
+    entry->deleted = true;
+    releaseEmail(entry->user.email, entry->user.id);
+    users_.erase(card_id);
+    users_by_id_.erase(entry->user.id);
+    return true;
+}
+
+// Borrow Operations
+bool InMemoryStorage::createBorrowRecord(const std::string& book_qr, const std::string& user_card) {
+    auto book = books_.find(book_qr);
+    if (!book) {
+        return false;  // Book not found
+    }
+    auto user = users_.find(user_card);
+    if (!user) {
+        return false;  // User not found
+    }
+
+    std::string borrow_date = today();
+
+    // 同時鎖住這位使用者與這本書（std::scoped_lock 會避免鎖順序造成的 deadlock）
+    std::scoped_lock lock(user->mutex, book->mutex);
+    if (book->deleted || user->deleted) {
+        return false;
+    }
+    if (book->book.status == "borrowed") {
+        return false;  // Book is already borrowed
+    }
+    if (user->active_loans >= kMaxActiveLoans) {
+        return false;  // User has reached maximum borrowing limit
+    }
+
+    auto record = std::make_shared<BorrowRecord>();
+    record->record_id = next_record_id_++;
+    record->book_id = book->book.id;
+    record->user_id = user->user.id;
+    record->borrow_date = borrow_date;
+    record->due_date = addDays(borrow_date, kLoanPeriodDays);
+
+    book->book.status = "borrowed";
+    ++book->book.version;
+    book->history.push_back(record);
+    user->history.push_back(record);
+    ++user->active_loans;
+    return true;
+}
+
+bool InMemoryStorage::returnBook(const std::string& book_qr) {
+    auto book = books_.find(book_qr);
+    if (!book) {
+        return false;  // Book not found
+    }
+
+    // 1. 先找出最近一筆未歸還的記錄，得知借閱者
+    RecordPtr active;
+    {
+        std::lock_guard<std::mutex> lock(book->mutex);
+        if (book->deleted || book->book.status == "available") {
+            return false;  // Book is already returned
+        }
+        for (auto it = book->history.rbegin(); it != book->history.rend(); ++it) {
+            if (!(*it)->return_date) {
+                active = *it;
+                break;
+            }
+        }
+    }
+    if (!active) {
+        return false;  // No active borrowing record found
+    }
+
+    auto user = users_by_id_.find(active->user_id);
+    if (!user) {
+        return false;
+    }
+
+    std::string return_date = today();
+
+    // 2. 鎖住雙方後再確認一次，期間可能已被其他執行緒歸還
+    std::scoped_lock lock(user->mutex, book->mutex);
+    if (active->return_date || book->book.status == "available") {
+        return false;
+    }
+    active->return_date = return_date;
+    book->book.status = "available";
+    ++book->book.version;
+    --user->active_loans;
+    return true;
+}
+
+std::vector<BorrowRecord> InMemoryStorage::getUserBorrowHistory(const std::string& user_card) {
+    auto user = users_.find(user_card);
+    if (!user) {
+        return {};
+    }
+    std::lock_guard<std::mutex> lock(user->mutex);
+    return newestFirst(user->history);
+}
+
+std::vector<BorrowRecord> InMemoryStorage::getBookBorrowHistory(const std::string& book_qr) {
+    auto book = books_.find(book_qr);
+    if (!book) {
+        return {};
+    }
+    std::lock_guard<std::mutex> lock(book->mutex);
+    return newestFirst(book->history);
+}
+
+std::optional<std::size_t> InMemoryStorage::countUserLoans(const std::string& user_card, bool open_only) {
+    auto user = users_.find(user_card);
+    if (!user) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(user->mutex);
+    return open_only ? static_cast<std::size_t>(user->active_loans) : user->history.size();
+}
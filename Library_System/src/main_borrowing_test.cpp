@@ -26,6 +26,8 @@ int main() {
         
         std::cout << "成功連接到資料庫！\n";
         DatabaseOperations ops;
+        // 櫃台操作每次最多等 2 秒，逾時會取消查詢並回報 Timeout
+        ops.setOperationTimeout(std::chrono::seconds(2));
 
         // 1. 測試借書
         std::cout << "\n=== 測試借書功能 ===\n";
@@ -73,6 +75,8 @@ int main() {
                     std::cout << "更新後的借閱記錄：\n";
                     printBorrowRecord(updated_history[0]);  // 顯示最新的記錄
                 }
+            } else if (ops.lastError() == OperationError::Timeout) {
+                std::cout << "還書逾時！\n";
             } else {
                 std::cout << "還書失敗！\n";
             }
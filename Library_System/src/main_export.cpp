@@ -0,0 +1,49 @@
+#include <iostream>
+#include "database.h"
+#include "borrow_exporter.h"
+
+int main(int argc, char* argv[]) {
+    std::string path = argc > 1 ? argv[1] : "borrow_records.lbc";
+
+    try {
+        DatabaseConnection::initialize("127.0.0.1", "library_user", "password123", "My_First_DB", 3306);
+        DatabaseConnection& db = DatabaseConnection::getInstance();
+        
+        if (!db.connect()) {
+            std::cerr << "無法連接到資料庫: " << db.getLastError() << std::endl;
+            return 1;
+        }
+        
+        std::cout << "成功連接到資料庫！\n";
+
+        // 1. 匯出借閱記錄
+        std::cout << "\n=== 匯出借閱記錄 ===\n";
+        BorrowRecordExporter exporter(db);
+        ExportStats stats = exporter.exportTo(path);
+        std::cout << "共匯出 " << stats.rows << " 筆，" << stats.row_groups << " 個 row group，"
+                  << stats.bytes_written << " bytes，耗時 " << stats.seconds << " 秒\n";
+
+        // 2. 只讀回需要的欄位；status 是書目前的狀態，不是這筆記錄的，
+        //    尚未歸還的記錄以 return_date 為 NULL 判斷
+        std::cout << "\n=== 讀取 return_date 欄位 ===\n";
+        ColumnarReader reader(path);
+        std::size_t borrowed = 0;
+        for (std::size_t g = 0; g < reader.rowGroups().size(); ++g) {
+            std::vector<bool> present;
+            reader.readIntegers(g, "return_date", &present);
+            for (bool returned : present) {
+                borrowed += !returned;
+            }
+        }
+        std::cout << "目前借出中的借閱記錄: " << borrowed << " 筆\n";
+
+        db.disconnect();
+        std::cout << "\n已斷開資料庫連接\n";
+        
+    } catch (const std::exception& e) {
+        std::cerr << "發生錯誤：" << e.what() << std::endl;
+        return 1;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include <iostream>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "in_memory_storage.h"
+#include "sharded_operations.h"
+
+void printBorrowRecord(const BorrowRecord& record) {
+    std::cout << "----------------------------------------\n";
+    std::cout << "借閱記錄 ID: " << record.record_id << "\n";
+    std::cout << "書籍 ID: " << record.book_id << "\n";
+    std::cout << "使用者 ID: " << record.user_id << "\n";
+    std::cout << "借閱日期: " << record.borrow_date << "\n";
+    std::cout << "應還日期: " << record.due_date << "\n";
+    std::cout << "實際還書日期: " << (record.return_date ? *record.return_date : "尚未歸還") << "\n";
+    std::cout << "----------------------------------------\n";
+}
+
+int main() {
+    // 不需要 mysqld，資料都在記憶體裡
+    InMemoryStorage storage;
+
+    for (int i = 0; i < 10; ++i) {
+        storage.createBook(Book{0, "", "測試書籍 " + std::to_string(i + 1), "作者", "9789571234567", 2024, ""});
+    }
+    storage.createUser(User{0, "", "陳小明", "ming@example.com", "0912345678"});
+    storage.createUser(User{0, "", "王小華", "wang@example.com", "0923456789"});
+
+    // 1. 測試借書與借閱上限
+    std::cout << "\n=== 測試借書功能 ===\n";
+    for (int i = 1; i <= 6; ++i) {
+        std::string qr = "BOOK0000000" + std::to_string(i);
+        bool ok = storage.createBorrowRecord(qr, "USER00000001");
+        std::cout << qr << (ok ? " 借出成功\n" : " 借出失敗\n");
+    }
+    std::cout << "重複借出 BOOK00000001: "
+              << (storage.createBorrowRecord("BOOK00000001", "USER00000002") ? "成功" : "失敗（預期）") << "\n";
+
+    // 2. 測試還書
+    std::cout << "\n=== 測試還書功能 ===\n";
+    std::cout << "還 BOOK00000001: " << (storage.returnBook("BOOK00000001") ? "成功" : "失敗") << "\n";
+    std::cout << "再還一次: " << (storage.returnBook("BOOK00000001") ? "成功" : "失敗（預期）") << "\n";
+    for (const auto& record : storage.getBookBorrowHistory("BOOK00000001")) {
+        printBorrowRecord(record);
+    }
+
+    // 3. 多執行緒借還書
+    std::cout << "\n=== 測試多執行緒借還書 ===\n";
+    const int kThreads = 4;
+    const int kRounds = 100000;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&storage, t] {
+            std::string qr = "BOOK0000000" + std::to_string(7 + t % 3);
+            for (int i = 0; i < kRounds; ++i) {
+                storage.createBorrowRecord(qr, "USER00000002");
+                storage.returnBook(qr);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "使用者 USER00000002 借閱記錄數: " << storage.getUserBorrowHistory("USER00000002").size()
+              << "，耗時 " << elapsed << " 秒\n";
+
+    // 4. 分片：三個 backend，書依分館前綴分配，使用者每個分片各一份
+    std::cout << "\n=== 測試分片 ===\n";
+    std::vector<std::unique_ptr<LibraryStorage>> shards;
+    std::vector<InMemoryStorage*> branches;
+    for (int i = 0; i < 3; ++i) {
+        auto branch = std::make_unique<InMemoryStorage>();
+        branches.push_back(branch.get());
+        shards.push_back(std::move(branch));
+    }
+    auto router = std::make_unique<PrefixShardRouter>(3);
+    router->addPrefix("TPE-", 0);
+    router->addPrefix("TXG-", 1);
+    router->addPrefix("KHH-", 2);
+    ShardedOperations sharded(std::move(shards), std::move(router));
+
+    sharded.createUser(User{0, "CARD0001", "陳小明", "ming@example.com", "0912345678"});
+    for (const char* prefix : {"TPE-", "TXG-", "KHH-"}) {
+        for (int i = 1; i <= 2; ++i) {
+            std::string qr = prefix + std::to_string(1000 + i);
+            sharded.createBook(Book{0, qr, "分館書籍 " + qr, "作者", "9789571234567", 2024, ""});
+        }
+    }
+    for (const auto& book : sharded.getAllBooks()) {
+        std::cout << book.qr_code << " 在分片 " << sharded.router().shardFor(book.qr_code) << "\n";
+    }
+
+    // 各分館的借書日期不同，合併後仍依 borrow_date 由新到舊
+    const char* dates[] = {"2024-03-01", "2024-03-05", "2024-03-03"};
+    for (int i = 0; i < 3; ++i) {
+        std::string date = dates[i];
+        branches[i]->setDateSource([date] { return date; });
+    }
+    for (const char* qr : {"TPE-1001", "TXG-1001", "KHH-1001", "TPE-1002", "TXG-1002"}) {
+        std::cout << qr << (sharded.createBorrowRecord(qr, "CARD0001") ? " 借出成功\n" : " 借出失敗\n");
+    }
+    std::cout << "第 6 本（跨分片上限）: "
+              << (sharded.createBorrowRecord("KHH-1002", "CARD0001") ? "成功" : "失敗（預期）") << "\n";
+    for (const auto& record : sharded.getUserBorrowHistory("CARD0001")) {
+        std::cout << "借閱日期 " << record.borrow_date << "\n";
+    }
+
+    // 5. 部分更新與 version 衝突
+    std::cout << "\n=== 測試部分更新 ===\n";
+    Book before = *storage.getBook("BOOK00000010");
+    Book edited = before;
+    edited.title = "測試書籍 10（修訂版）";
+    BookPatch patch = BookPatch::diff(before, edited);   // 只含 title
+    std::cout << "第一次更新: "
+              << (storage.patchBook(patch) == UpdateResult::Applied ? "成功" : "失敗") << "\n";
+    std::cout << "用舊 version 再更新一次: "
+              << (storage.patchBook(patch) == UpdateResult::Conflict ? "衝突（預期）" : "未偵測到衝突") << "\n";
+    auto after = storage.getBook("BOOK00000010");
+    std::cout << after->title << "，version " << after->version << "\n";
+
+    return 0;
+}
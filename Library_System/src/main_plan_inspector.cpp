@@ -0,0 +1,131 @@
+#include <iostream>
+#include <cstring>
+#include "database.h"
+#include "database_operation.h"
+#include "plan_inspector.h"
+
+int main(int argc, char* argv[]) {
+    std::string baseline_path;
+    std::string write_path;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--baseline") == 0) {
+            baseline_path = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--write-baseline") == 0) {
+            write_path = argv[i + 1];
+        }
+    }
+
+    try {
+        // 代表性操作會寫入資料，用專用連線在交易中執行，分析完再回滾
+        auto db = DatabaseConnection::create("127.0.0.1", "library_user", "password123", "My_First_DB", 3306);
+        
+        if (!db->connect()) {
+            std::cerr << "無法連接到資料庫: " << db->getLastError() << std::endl;
+            return 1;
+        }
+        
+        std::cout << "成功連接到資料庫！\n";
+
+        MYSQL* conn = db->getRawConnection();
+        if (mysql_query(conn, "START TRANSACTION") != 0) {
+            std::cerr << "無法開始交易: " << mysql_error(conn) << std::endl;
+            return 1;
+        }
+        // ensureConnection() 斷線重連後就不在這個交易裡，之後的寫入會直接提交
+        unsigned long workload_thread = db->getThreadId();
+
+        PlanInspector inspector;
+        DatabaseOperations ops(*db);
+        ops.setStatementObserver([&](const std::string& query, uint64_t rows, bool ok) {
+            inspector.record(query, rows, ok);
+        });
+
+        // 1. 跑一輪代表性的操作；涵蓋自動編號的新增（MAX(book_id) / MAX(user_id) 子查詢）。
+        //    borrow_book / return_book procedure 自己會 START TRANSACTION / COMMIT，
+        //    會把外層交易一起提交，而 CALL 本身也無法 EXPLAIN，所以不執行借還書
+        std::cout << "\n=== 執行代表性操作 ===\n";
+        std::string test_book_qr = "BOOK00000001";
+        std::string test_user_card = "USER00000001";
+
+        auto book = ops.getBook(test_book_qr);
+        auto user = ops.getUser(test_user_card);
+        ops.getBooks({test_book_qr, "BOOK00000002", "BOOK00000003"});
+        ops.getUsers({test_user_card, "USER00000002"});
+        ops.getUserBorrowHistory(test_user_card);
+        ops.getBookBorrowHistory(test_book_qr);
+        if (book) ops.updateBook(*book);
+        if (user) ops.updateUser(*user);
+        ops.deleteBook("BOOK_NOT_EXIST");
+
+        Book new_book{0, "", "Plan Inspector Sample", "Plan Inspector", "0000000000", 2024, "available"};
+        User new_user{0, "", "Plan Inspector", "plan.inspector@example.com", "0000000000"};
+        ops.createBook(new_book);
+        ops.createUser(new_user);
+        ops.getAllBooks();
+        ops.getAllUsers();
+
+        // 2. 分析執行計畫
+        std::cout << "\n=== 執行計畫分析 ===\n";
+        if (db->getThreadId() != workload_thread) {
+            std::cerr << "執行代表性操作時連線中斷，部分寫入可能已提交" << std::endl;
+            return 1;
+        }
+        // 在同一個交易裡 EXPLAIN，看得到剛寫入的資料
+        conn = db->getRawConnection();
+        auto findings = inspector.inspect(conn);
+        if (mysql_query(conn, "ROLLBACK") != 0) {
+            std::cerr << "無法回滾代表性操作: " << mysql_error(conn) << std::endl;
+            return 1;
+        }
+        std::size_t flagged = 0;
+        for (const auto& finding : findings) {
+            std::cout << "----------------------------------------\n";
+            std::cout << finding.statement_template << "\n";
+            std::cout << "執行次數: " << finding.executions
+                      << "（失敗 " << finding.failures << "）"
+                      << "，平均回傳列數: " << finding.avg_rows_returned
+                      << "，估計檢查列數: " << finding.rows_examined
+                      << "，標記: " << finding.flagString() << "\n";
+            for (const auto& note : finding.notes) {
+                std::cout << "  - " << note << "\n";
+            }
+            if (!finding.error.empty()) {
+                std::cout << "  EXPLAIN 失敗: " << finding.error << "\n";
+            }
+            flagged += finding.flagged();
+        }
+        std::cout << "----------------------------------------\n";
+        std::cout << "共 " << findings.size() << " 種語句，其中 " << flagged << " 種需要注意\n";
+
+        // 3. 與基準比較或寫入基準
+        int exit_code = 0;
+        if (!write_path.empty()) {
+            if (PlanInspector::writeBaseline(write_path, findings)) {
+                std::cout << "已寫入基準檔: " << write_path << "\n";
+            } else {
+                std::cerr << "無法寫入基準檔: " << write_path << std::endl;
+                exit_code = 1;
+            }
+        }
+        if (!baseline_path.empty()) {
+            auto regressions = PlanInspector::compareBaseline(baseline_path, findings);
+            if (regressions.empty()) {
+                std::cout << "與基準相比沒有退化\n";
+            } else {
+                std::cout << "與基準相比有 " << regressions.size() << " 項退化：\n";
+                for (const auto& regression : regressions) {
+                    std::cout << "  - " << regression << "\n";
+                }
+                exit_code = 1;
+            }
+        }
+
+        db->disconnect();
+        std::cout << "\n已斷開資料庫連接\n";
+        return exit_code;
+        
+    } catch (const std::exception& e) {
+        std::cerr << "發生錯誤：" << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,77 @@
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "database.h"
+#include "database_operation.h"
+#include "resharder.h"
+#include "sharded_operations.h"
+
+// 用法：main_reshard <來源 port> <目標 port> [目標 port ...]
+// 例如本機跑多個 mysqld：main_reshard 3306 3307 3308 3309
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "用法: " << argv[0] << " <source_port> <target_port> [target_port ...]\n";
+        return 1;
+    }
+
+    try {
+        auto open = [](const char* port) {
+            auto conn = DatabaseConnection::create("127.0.0.1", "library_user", "password123",
+                                                   "My_First_DB", static_cast<unsigned int>(std::stoul(port)));
+            if (!conn->connect()) {
+                throw std::runtime_error(std::string("無法連接到 port ") + port + ": " + conn->getLastError());
+            }
+            return conn;
+        };
+
+        auto source = open(argv[1]);
+        std::vector<std::unique_ptr<DatabaseConnection>> targets;
+        for (int i = 2; i < argc; ++i) {
+            targets.push_back(open(argv[i]));
+        }
+        std::cout << "成功連接到 1 個來源與 " << targets.size() << " 個目標資料庫！\n";
+
+        // 1. 依 qr_code 的 hash 重新分配
+        std::cout << "\n=== 複製資料到新的分片 ===\n";
+        std::vector<DatabaseConnection*> target_ptrs;
+        for (auto& target : targets) {
+            target_ptrs.push_back(target.get());
+        }
+        HashShardRouter router(targets.size());
+        Resharder resharder({source.get()}, target_ptrs, router);
+        ReshardStats stats = resharder.run();
+
+        std::cout << "使用者: " << stats.users << " / " << stats.source_users << " 位（每個分片各一份）\n";
+        for (std::size_t i = 0; i < targets.size(); ++i) {
+            std::cout << "分片 " << i << ": 書籍 " << stats.books[i]
+                      << " 本，借閱記錄 " << stats.borrow_records[i] << " 筆\n";
+        }
+        std::cout << "耗時 " << stats.seconds << " 秒，驗證"
+                  << (stats.verified ? "通過" : "失敗：筆數與來源不符") << "\n";
+        if (!stats.verified) {
+            return 1;
+        }
+
+        // 2. 透過 ShardedOperations 讀回來確認
+        std::cout << "\n=== 跨分片查詢 ===\n";
+        std::vector<std::unique_ptr<LibraryStorage>> shards;
+        for (auto& target : targets) {
+            shards.push_back(std::make_unique<DatabaseOperations>(*target));
+        }
+        ShardedOperations sharded(std::move(shards), std::make_unique<HashShardRouter>(targets.size()));
+
+        std::cout << "書籍總數: " << sharded.getAllBooks().size() << "\n";
+        auto history = sharded.getUserBorrowHistory("USER00000001");
+        std::cout << "USER00000001 借閱記錄: " << history.size() << " 筆";
+        if (!history.empty()) {
+            std::cout << "，最近一次借閱 " << history.front().borrow_date;
+        }
+        std::cout << "\n";
+
+    } catch (const std::exception& e) {
+        std::cerr << "發生錯誤：" << e.what() << std::endl;
+        return 1;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include <iostream>
+#include <iomanip>
+#include "database.h"
+#include "circulation_stats.h"
+
+int main(int argc, char* argv[]) {
+    // 狀態檔存在時只處理上次之後的新記錄
+    std::string state_path = argc > 1 ? argv[1] : "circulation_state.txt";
+
+    try {
+        DatabaseConnection::initialize("127.0.0.1", "library_user", "password123", "My_First_DB", 3306);
+        DatabaseConnection& db = DatabaseConnection::getInstance();
+        
+        if (!db.connect()) {
+            std::cerr << "無法連接到資料庫: " << db.getLastError() << std::endl;
+            return 1;
+        }
+        
+        CirculationState state;
+        bool incremental = state.load(state_path);
+        std::cout << (incremental ? "增量統計，從 record_id > " + std::to_string(state.watermark.highWater()) +
+                                        " 開始，待補區間 " + std::to_string(state.watermark.gaps().size()) + " 個\n"
+                                  : "完整統計\n");
+
+        CirculationStats stats(db, 4);
+        CirculationReport report = stats.run(state, 10);
+
+        std::cout << "\n=== 每日借閱統計 ===\n";
+        std::cout << "本次掃描: " << report.scanned_records << " 筆，耗時 " << report.seconds << " 秒\n";
+        std::cout << "總借閱: " << report.total_loans << "，已歸還: " << report.returned_loans
+                  << "，未歸還: " << report.open_loans << "（逾期 " << report.overdue_loans << "）\n";
+        std::cout << "平均借閱天數: " << std::fixed << std::setprecision(2) << report.average_loan_days << "\n";
+
+        const char* buckets[kLatenessBuckets] = {"準時", "1-3 天", "4-7 天", "8-14 天", "15-30 天", "30 天以上"};
+        std::cout << "\n還書逾期分布：\n";
+        for (std::size_t i = 0; i < kLatenessBuckets; ++i) {
+            std::cout << "  " << buckets[i] << ": " << report.lateness[i] << "\n";
+        }
+
+        std::cout << "\n熱門書籍：\n";
+        for (const auto& title : report.top_titles) {
+            std::cout << "  " << title.title << " (ID " << title.book_id << "): " << title.loans << " 次\n";
+        }
+
+        std::cout << "\n借閱最多的讀者：\n";
+        for (const auto& patron : report.top_patrons) {
+            std::cout << "  " << patron.card_id << ": " << patron.loans << " 次，逾期 "
+                      << patron.late_returns << " 次\n";
+        }
+
+        if (!state.save(state_path)) {
+            std::cerr << "無法儲存統計狀態: " << state_path << std::endl;
+        }
+
+        db.disconnect();
+        
+    } catch (const std::exception& e) {
+        std::cerr << "發生錯誤：" << e.what() << std::endl;
+        return 1;
+    }
+    
+    return 0;
+}
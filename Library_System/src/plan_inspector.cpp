@@ -0,0 +1,454 @@
+#include "plan_inspector.h"
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+// ---- 簡易 JSON 解析，只用來讀 EXPLAIN FORMAT=JSON 的輸出 ----
+
+struct Json {
+    enum class Type { Null, Bool, Number, String, Array, Object };
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<Json> array;
+    std::vector<std::pair<std::string, Json>> object;
+
+    const Json* get(const std::string& key) const {
+        for (const auto& member : object) {
+            if (member.first == key) {
+                return &member.second;
+            }
+        }
+        return nullptr;
+    }
+
+    // EXPLAIN 有些版本把數字輸出成字串
+    double asNumber() const {
+        if (type == Type::Number) return number;
+        if (type == Type::String) return std::strtod(string.c_str(), nullptr);
+        return 0.0;
+    }
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& text) : text_(text), pos_(0) {}
+
+    Json parse() {
+        Json value = parseValue();
+        skipSpace();
+        if (pos_ != text_.size()) {
+            throw std::runtime_error("Trailing characters in EXPLAIN output");
+        }
+        return value;
+    }
+
+private:
+    void skipSpace() {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) {
+            ++pos_;
+        }
+    }
+
+    char peek() {
+        skipSpace();
+        if (pos_ >= text_.size()) {
+            throw std::runtime_error("Unexpected end of EXPLAIN output");
+        }
+        return text_[pos_];
+    }
+
+    void expect(char c) {
+        if (peek() != c) {
+            throw std::runtime_error(std::string("Expected '") + c + "' in EXPLAIN output");
+        }
+        ++pos_;
+    }
+
+    Json parseValue() {
+        Json value;
+        char c = peek();
+        if (c == '{') {
+            value.type = Json::Type::Object;
+            ++pos_;
+            if (peek() == '}') {
+                ++pos_;
+                return value;
+            }
+            while (true) {
+                std::string key = parseString();
+                expect(':');
+                value.object.emplace_back(std::move(key), parseValue());
+                if (peek() == ',') {
+                    ++pos_;
+                    continue;
+                }
+                expect('}');
+                return value;
+            }
+        }
+        if (c == '[') {
+            value.type = Json::Type::Array;
+            ++pos_;
+            if (peek() == ']') {
+                ++pos_;
+                return value;
+            }
+            while (true) {
+                value.array.push_back(parseValue());
+                if (peek() == ',') {
+                    ++pos_;
+                    continue;
+                }
+                expect(']');
+                return value;
+            }
+        }
+        if (c == '"') {
+            value.type = Json::Type::String;
+            value.string = parseString();
+            return value;
+        }
+        if (text_.compare(pos_, 4, "true") == 0) {
+            value.type = Json::Type::Bool;
+            value.boolean = true;
+            pos_ += 4;
+            return value;
+        }
+        if (text_.compare(pos_, 5, "false") == 0) {
+            value.type = Json::Type::Bool;
+            pos_ += 5;
+            return value;
+        }
+        if (text_.compare(pos_, 4, "null") == 0) {
+            pos_ += 4;
+            return value;
+        }
+        char* end = nullptr;
+        value.type = Json::Type::Number;
+        value.number = std::strtod(text_.c_str() + pos_, &end);
+        if (end == text_.c_str() + pos_) {
+            throw std::runtime_error("Invalid value in EXPLAIN output");
+        }
+        pos_ = static_cast<std::size_t>(end - text_.c_str());
+        return value;
+    }
+
+    std::string parseString() {
+        expect('"');
+        std::string out;
+        while (pos_ < text_.size() && text_[pos_] != '"') {
+            char c = text_[pos_++];
+            if (c == '\\' && pos_ < text_.size()) {
+                char escaped = text_[pos_++];
+                switch (escaped) {
+                    case 'n': out.push_back('\n'); break;
+                    case 't': out.push_back('\t'); break;
+                    case 'u': out.push_back('?'); pos_ += 4; break;   // 不需要還原 unicode
+                    default: out.push_back(escaped); break;
+                }
+            } else {
+                out.push_back(c);
+            }
+        }
+        expect('"');
+        return out;
+    }
+
+    std::string text_;
+    std::size_t pos_;
+};
+
+// ---- 走訪執行計畫 ----
+
+bool isTrue(const Json* value) {
+    return value && value->type == Json::Type::Bool && value->boolean;
+}
+
+std::string tableName(const Json& table) {
+    const Json* name = table.get("table_name");
+    return name ? name->string : "?";
+}
+
+double walkPlan(const Json& node, PlanFinding& finding);
+
+// 單一 table 節點：檢查存取方式，並遞迴處理子查詢
+double visitTable(const Json& table, PlanFinding& finding) {
+    const Json* access = table.get("access_type");
+    if (access && (access->string == "ALL" || access->string == "index")) {
+        finding.full_scan = true;
+        finding.notes.push_back((access->string == "ALL" ? "full table scan on " : "full index scan on ")
+                                + tableName(table));
+    }
+    double examined = 0.0;
+    if (const Json* rows = table.get("rows_examined_per_scan")) {
+        examined = rows->asNumber();
+    }
+    for (const auto& member : table.object) {
+        if (member.second.type == Json::Type::Object || member.second.type == Json::Type::Array) {
+            examined += walkPlan(member.second, finding);
+        }
+    }
+    return examined;
+}
+
+// 回傳估計檢查的列數；nested loop 中每個 table 的掃描次數等於前一層產出的列數
+double walkPlan(const Json& node, PlanFinding& finding) {
+    double examined = 0.0;
+
+    if (node.type == Json::Type::Array) {
+        for (const auto& item : node.array) {
+            examined += walkPlan(item, finding);
+        }
+        return examined;
+    }
+    if (node.type != Json::Type::Object) {
+        return 0.0;
+    }
+
+    if (isTrue(node.get("using_filesort"))) {
+        finding.filesort = true;
+    }
+    if (isTrue(node.get("using_temporary_table"))) {
+        finding.temporary_table = true;
+    }
+
+    for (const auto& member : node.object) {
+        if (member.first == "nested_loop" && member.second.type == Json::Type::Array) {
+            double prefix = 1.0;
+            for (const auto& step : member.second.array) {
+                const Json* table = step.get("table");
+                if (!table) {
+                    examined += walkPlan(step, finding);
+                    continue;
+                }
+                examined += prefix * visitTable(*table, finding);
+                if (const Json* produced = table->get("rows_produced_per_join")) {
+                    prefix = produced->asNumber();
+                }
+            }
+        } else if (member.first == "table" && member.second.type == Json::Type::Object) {
+            examined += visitTable(member.second, finding);
+        } else if (member.second.type == Json::Type::Object || member.second.type == Json::Type::Array) {
+            examined += walkPlan(member.second, finding);
+        }
+    }
+    return examined;
+}
+
+bool isExplainable(const std::string& query) {
+    std::size_t start = query.find_first_not_of(" \t\n");
+    if (start == std::string::npos) {
+        return false;
+    }
+    std::string verb;
+    for (std::size_t i = start; i < query.size() && std::isalpha(static_cast<unsigned char>(query[i])); ++i) {
+        verb.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(query[i]))));
+    }
+    return verb == "SELECT" || verb == "INSERT" || verb == "UPDATE" ||
+           verb == "DELETE" || verb == "REPLACE";
+}
+
+} // namespace
+
+std::string PlanFinding::flagString() const {
+    std::string flags;
+    if (full_scan) flags += "scan,";
+    if (filesort) flags += "filesort,";
+    if (temporary_table) flags += "temp,";
+    if (flags.empty()) {
+        return "-";
+    }
+    flags.pop_back();
+    return flags;
+}
+
+// 把字串與數字常數換成 ?，IN (?, ?, ...) 收斂成 IN (?...)，讓同一種查詢歸成同一個 template
+std::string PlanInspector::normalize(const std::string& query) {
+    std::string out;
+    out.reserve(query.size());
+    for (std::size_t i = 0; i < query.size(); ++i) {
+        char c = query[i];
+        if (c == '\'') {
+            ++i;
+            while (i < query.size() && query[i] != '\'') {
+                if (query[i] == '\\') {
+                    ++i;
+                }
+                ++i;
+            }
+            out.push_back('?');
+        } else if (std::isdigit(static_cast<unsigned char>(c)) &&
+                   (out.empty() || !(std::isalnum(static_cast<unsigned char>(out.back())) || out.back() == '_'))) {
+            while (i + 1 < query.size() &&
+                   (std::isdigit(static_cast<unsigned char>(query[i + 1])) || query[i + 1] == '.')) {
+                ++i;
+            }
+            out.push_back('?');
+        } else {
+            out.push_back(c);
+        }
+    }
+
+    std::string collapsed;
+    collapsed.reserve(out.size());
+    for (std::size_t i = 0; i < out.size(); ++i) {
+        if (out.compare(i, 3, "(?,") == 0) {
+            std::size_t j = i + 1;
+            while (out.compare(j, 3, "?, ") == 0) {
+                j += 3;
+            }
+            if (out.compare(j, 2, "?)") == 0) {
+                collapsed += "(?...)";
+                i = j + 1;
+                continue;
+            }
+        }
+        collapsed.push_back(out[i]);
+    }
+    return collapsed;
+}
+
+void PlanInspector::record(const std::string& query, uint64_t rows, bool ok) {
+    std::string key = normalize(query);
+    std::lock_guard<std::mutex> lock(mutex_);
+    Capture& capture = captures_[key];
+    if (capture.executions == 0) {
+        capture.sample = query;
+    }
+    ++capture.executions;
+    if (ok) {
+        capture.rows += rows;
+    } else {
+        ++capture.failures;
+    }
+}
+
+std::vector<PlanFinding> PlanInspector::inspect(MYSQL* conn) {
+    std::map<std::string, Capture> captures;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        captures = captures_;
+    }
+
+    std::vector<PlanFinding> findings;
+    for (const auto& entry : captures) {
+        PlanFinding finding;
+        finding.statement_template = entry.first;
+        finding.sample = entry.second.sample;
+        finding.executions = entry.second.executions;
+        finding.failures = entry.second.failures;
+        uint64_t succeeded = entry.second.executions - entry.second.failures;
+        finding.avg_rows_returned = succeeded > 0 ? static_cast<double>(entry.second.rows) / succeeded : 0.0;
+
+        if (!isExplainable(finding.sample)) {
+            finding.notes.push_back("not explainable (stored procedure or session statement)");
+            findings.push_back(std::move(finding));
+            continue;
+        }
+
+        std::string explain = "EXPLAIN FORMAT=JSON " + finding.sample;
+        if (mysql_query(conn, explain.c_str()) != 0) {
+            finding.error = mysql_error(conn);
+            findings.push_back(std::move(finding));
+            continue;
+        }
+        MYSQL_RES* result = mysql_store_result(conn);
+        MYSQL_ROW row = result ? mysql_fetch_row(result) : nullptr;
+        if (row && row[0]) {
+            try {
+                Json plan = JsonParser(row[0]).parse();
+                finding.rows_examined = walkPlan(plan, finding);
+                finding.explained = true;
+            } catch (const std::exception& e) {
+                finding.error = e.what();
+            }
+        } else {
+            finding.error = "empty EXPLAIN result";
+        }
+        if (result) {
+            mysql_free_result(result);
+        }
+        findings.push_back(std::move(finding));
+    }
+    return findings;
+}
+
+bool PlanInspector::writeBaseline(const std::string& path, const std::vector<PlanFinding>& findings) {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+    // flags <TAB> rows_examined <TAB> template
+    for (const auto& finding : findings) {
+        if (finding.explained) {
+            out << finding.flagString() << "\t" << finding.rows_examined << "\t"
+                << finding.statement_template << "\n";
+        }
+    }
+    return static_cast<bool>(out.flush());
+}
+
+std::vector<std::string> PlanInspector::compareBaseline(const std::string& path,
+                                                        const std::vector<PlanFinding>& findings,
+                                                        double growth_factor) {
+    struct Baseline {
+        std::string flags;
+        double rows_examined;
+    };
+    std::map<std::string, Baseline> baseline;
+
+    std::ifstream in(path);
+    if (!in) {
+        // 讀不到基準時若當成空基準，只會回報有問題的新語句，等於沒有比較
+        throw std::runtime_error("Cannot open baseline file: " + path);
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        std::size_t first = line.find('\t');
+        std::size_t second = first == std::string::npos ? first : line.find('\t', first + 1);
+        if (second == std::string::npos) {
+            continue;
+        }
+        baseline[line.substr(second + 1)] = Baseline{
+            line.substr(0, first),
+            std::strtod(line.c_str() + first + 1, nullptr)};
+    }
+
+    std::vector<std::string> regressions;
+    for (const auto& finding : findings) {
+        if (!finding.explained) {
+            continue;
+        }
+        auto it = baseline.find(finding.statement_template);
+        if (it == baseline.end()) {
+            // 新的 template 沒有 baseline，有問題的計畫一律視為退步
+            if (finding.flagged()) {
+                regressions.push_back("new statement with " + finding.flagString() + ": " +
+                                      finding.statement_template);
+            }
+            continue;
+        }
+
+        const std::string& old_flags = it->second.flags;
+        for (const char* flag : {"scan", "filesort", "temp"}) {
+            if (finding.flagString().find(flag) != std::string::npos &&
+                old_flags.find(flag) == std::string::npos) {
+                regressions.push_back(std::string("new ") + flag + ": " + finding.statement_template);
+            }
+        }
+        if (it->second.rows_examined > 0 &&
+            finding.rows_examined > it->second.rows_examined * growth_factor) {
+            std::ostringstream ss;
+            ss << "rows examined " << it->second.rows_examined << " -> " << finding.rows_examined
+               << ": " << finding.statement_template;
+            regressions.push_back(ss.str());
+        }
+    }
+    return regressions;
+}
@@ -0,0 +1,119 @@
+#include "query_watchdog.h"
+#include "async_logger.h"
+#include <string>
+
+QueryWatchdog::QueryWatchdog(DatabaseConnection& db)
+    : db_(db)
+    , side_connection_(nullptr)
+    , next_ticket_(1)
+    , stopping_(false) {
+    thread_ = std::thread(&QueryWatchdog::run, this);
+}
+
+QueryWatchdog::~QueryWatchdog() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    changed_.notify_all();
+    thread_.join();
+    if (side_connection_) {
+        mysql_close(side_connection_);
+    }
+}
+
+bool QueryWatchdog::connect() {
+    std::lock_guard<std::mutex> lock(side_mutex_);
+    if (!side_connection_) {
+        side_connection_ = db_.openSideConnection();
+    }
+    return side_connection_ != nullptr;
+}
+
+uint64_t QueryWatchdog::arm(unsigned long thread_id, Clock::time_point deadline) {
+    uint64_t ticket;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ticket = next_ticket_++;
+        watches_[ticket] = Watch{thread_id, deadline, State::Armed};
+    }
+    changed_.notify_all();
+    return ticket;
+}
+
+bool QueryWatchdog::disarm(uint64_t ticket) {
+    // 若背景執行緒正在送 KILL，這裡會等它送完，避免 KILL 打到下一個查詢
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = watches_.find(ticket);
+    if (it == watches_.end()) {
+        return false;
+    }
+    changed_.wait(lock, [&] { return it->second.state != State::Killing; });
+    bool fired = it->second.state == State::Killed;
+    watches_.erase(it);
+    return fired;
+}
+
+void QueryWatchdog::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        // 找出最早到期、還沒處理過的查詢
+        auto next = watches_.end();
+        for (auto it = watches_.begin(); it != watches_.end(); ++it) {
+            if (it->second.state == State::Armed &&
+                (next == watches_.end() || it->second.deadline < next->second.deadline)) {
+                next = it;
+            }
+        }
+
+        if (next == watches_.end()) {
+            changed_.wait(lock);
+            continue;
+        }
+
+        if (Clock::now() < next->second.deadline) {
+            changed_.wait_until(lock, next->second.deadline);
+            continue;
+        }
+
+        // 先複製 thread id 並標記為 Killing，送 KILL 時不持有 mutex_，
+        // arm() / disarm() 不會被慢的伺服器擋住；disarm() 會等到 KILL 送完
+        uint64_t ticket = next->first;
+        unsigned long thread_id = next->second.thread_id;
+        next->second.state = State::Killing;
+        lock.unlock();
+        killQuery(thread_id);
+        lock.lock();
+        auto it = watches_.find(ticket);
+        if (it != watches_.end()) {
+            it->second.state = State::Killed;
+        }
+        changed_.notify_all();
+    }
+}
+
+bool QueryWatchdog::killQuery(unsigned long thread_id) {
+    // 沒有事先 connect() 成功時在這裡建立，斷線時重新建立一次
+    std::lock_guard<std::mutex> lock(side_mutex_);
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (!side_connection_) {
+            side_connection_ = db_.openSideConnection();
+            if (!side_connection_) {
+                AsyncLogger::getInstance().log(LogLevel::Error, "watchdog",
+                                               "Could not open side connection");
+                return false;
+            }
+        }
+
+        std::string query = "KILL QUERY " + std::to_string(thread_id);
+        if (mysql_query(side_connection_, query.c_str()) == 0) {
+            return true;
+        }
+        AsyncLogger::getInstance().log(LogLevel::Error, "watchdog",
+                                       std::string("KILL QUERY failed: ") + mysql_error(side_connection_),
+                                       mysql_errno(side_connection_), std::chrono::microseconds(0), query);
+        mysql_close(side_connection_);
+        side_connection_ = nullptr;
+    }
+    return false;
+}
@@ -0,0 +1,264 @@
+#include "resharder.h"
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+
+namespace {
+
+void execute(MYSQL* conn, const std::string& query) {
+    if (mysql_query(conn, query.c_str()) != 0) {
+        throw std::runtime_error(std::string("Reshard query failed: ") + mysql_error(conn));
+    }
+}
+
+uint64_t countRows(MYSQL* conn, const std::string& query) {
+    execute(conn, query);
+    MYSQL_RES* result = mysql_store_result(conn);
+    if (!result) {
+        throw std::runtime_error(std::string("Reshard count failed: ") + mysql_error(conn));
+    }
+    MYSQL_ROW row = mysql_fetch_row(result);
+    uint64_t count = (row && row[0]) ? std::stoull(row[0]) : 0;
+    mysql_free_result(result);
+    return count;
+}
+
+// 用 mysql_use_result 逐列讀取，來源資料不必整份放進記憶體
+void streamRows(MYSQL* conn, const std::string& query, const std::function<void(MYSQL_ROW)>& fn) {
+    execute(conn, query);
+    MYSQL_RES* result = mysql_use_result(conn);
+    if (!result) {
+        throw std::runtime_error(std::string("Reshard read failed: ") + mysql_error(conn));
+    }
+    MYSQL_ROW row;
+    while ((row = mysql_fetch_row(result))) {
+        fn(row);
+    }
+    unsigned int err = mysql_errno(conn);
+    mysql_free_result(result);
+    if (err != 0) {
+        throw std::runtime_error(std::string("Reshard read interrupted: ") + mysql_error(conn));
+    }
+}
+
+// NULL 保留為 NULL，其餘用目標連線的字元集跳脫
+std::string quote(MYSQL* conn, const char* value) {
+    if (!value) {
+        return "NULL";
+    }
+    std::string text(value);
+    std::string escaped(text.size() * 2 + 1, '\0');
+    unsigned long length = mysql_real_escape_string(conn, &escaped[0], text.c_str(), text.size());
+    escaped.resize(length);
+    return "'" + escaped + "'";
+}
+
+// 把多筆資料組成一條 multi-row 語句寫到同一個目標；
+// require_all 時少寫任何一列都視為錯誤
+class BatchWriter {
+public:
+    BatchWriter(MYSQL* conn, std::string head, std::string separator, std::string tail,
+                std::size_t batch_size, bool require_all = false)
+        : conn_(conn), head_(std::move(head)), separator_(std::move(separator))
+        , tail_(std::move(tail)), batch_size_(batch_size), require_all_(require_all)
+        , pending_(0), written_(0) {}
+
+    MYSQL* connection() const { return conn_; }
+
+    void add(const std::string& row) {
+        query_ += pending_ == 0 ? head_ : separator_;
+        query_ += row;
+        if (++pending_ >= batch_size_) {
+            flush();
+        }
+    }
+
+    void flush() {
+        if (pending_ == 0) {
+            return;
+        }
+        execute(conn_, query_ + tail_);
+        uint64_t affected = mysql_affected_rows(conn_);
+        if (require_all_ && affected != pending_) {
+            throw std::runtime_error("Reshard wrote " + std::to_string(affected) + " of " +
+                                     std::to_string(pending_) + " rows; missing book or user on target");
+        }
+        written_ += affected;
+        query_.clear();
+        pending_ = 0;
+    }
+
+    uint64_t written() const { return written_; }
+
+private:
+    MYSQL* conn_;
+    std::string head_;
+    std::string separator_;
+    std::string tail_;
+    std::size_t batch_size_;
+    bool require_all_;
+    std::size_t pending_;
+    uint64_t written_;
+    std::string query_;
+};
+
+} // namespace
+
+Resharder::Resharder(std::vector<DatabaseConnection*> sources,
+                     std::vector<DatabaseConnection*> targets,
+                     const ShardRouter& router,
+                     std::size_t batch_size)
+    : sources_(std::move(sources))
+    , targets_(std::move(targets))
+    , router_(router)
+    , batch_size_(batch_size == 0 ? 1 : batch_size) {
+    if (sources_.empty() || targets_.empty() || router_.shardCount() != targets_.size()) {
+        throw std::invalid_argument("Resharder: router does not match the target list");
+    }
+}
+
+ReshardStats Resharder::run() {
+    auto start = std::chrono::steady_clock::now();
+    ReshardStats stats;
+    stats.books.assign(targets_.size(), 0);
+    stats.borrow_records.assign(targets_.size(), 0);
+
+    for (DatabaseConnection* target : targets_) {
+        MYSQL* conn = target->getRawConnection();
+        if (countRows(conn, "SELECT COUNT(*) FROM users") != 0 ||
+            countRows(conn, "SELECT COUNT(*) FROM books") != 0 ||
+            countRows(conn, "SELECT COUNT(*) FROM borrow_records") != 0) {
+            throw std::runtime_error("Reshard target is not empty: " + target->getCurrentDatabase());
+        }
+    }
+
+    copyUsers(stats);
+    copyBooks(stats);
+    copyBorrowRecords(stats);
+    verify(stats);
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+void Resharder::copyUsers(ReshardStats& stats) {
+    // 一般 INSERT 並要求整批寫入：目標上有重複的 card_id 會直接失敗，不會被靜默略過
+    std::vector<BatchWriter> writers;
+    for (DatabaseConnection* target : targets_) {
+        writers.emplace_back(target->getRawConnection(),
+                             "INSERT INTO users (card_id, name, email, phone, version) VALUES ",
+                             ", ", "", batch_size_, true);
+    }
+
+    // 來源若本身是分片，使用者在每個來源都有一份；以第一個來源的為準，依 card_id 去重
+    std::unordered_set<std::string> seen;
+    for (DatabaseConnection* source : sources_) {
+        streamRows(source->getRawConnection(),
+                   "SELECT card_id, name, email, phone, version FROM users ORDER BY user_id",
+                   [&](MYSQL_ROW row) {
+                       if (!row[0] || !seen.insert(row[0]).second) {
+                           return;
+                       }
+                       for (auto& writer : writers) {
+                           MYSQL* conn = writer.connection();
+                           writer.add("(" + quote(conn, row[0]) + ", " + quote(conn, row[1]) + ", " +
+                                      quote(conn, row[2]) + ", " + quote(conn, row[3]) + ", " +
+                                      quote(conn, row[4]) + ")");
+                       }
+                   });
+    }
+    for (auto& writer : writers) {
+        writer.flush();
+    }
+    stats.source_users = seen.size();
+    stats.users = writers.front().written();
+}
+
+void Resharder::copyBooks(ReshardStats& stats) {
+    std::vector<BatchWriter> writers;
+    for (DatabaseConnection* target : targets_) {
+        writers.emplace_back(target->getRawConnection(),
+                             "INSERT INTO books (qr_code, title, author, isbn, publication_year, status, version) VALUES ",
+                             ", ", "", batch_size_);
+    }
+
+    for (DatabaseConnection* source : sources_) {
+        streamRows(source->getRawConnection(),
+                   "SELECT qr_code, title, author, isbn, publication_year, status, version "
+                   "FROM books ORDER BY book_id",
+                   [&](MYSQL_ROW row) {
+                       BatchWriter& writer = writers[router_.shardFor(row[0])];
+                       MYSQL* conn = writer.connection();
+                       writer.add("(" + quote(conn, row[0]) + ", " + quote(conn, row[1]) + ", " +
+                                  quote(conn, row[2]) + ", " + quote(conn, row[3]) + ", " +
+                                  quote(conn, row[4]) + ", " + quote(conn, row[5]) + ", " +
+                                  quote(conn, row[6]) + ")");
+                   });
+    }
+    for (std::size_t i = 0; i < writers.size(); ++i) {
+        writers[i].flush();
+        stats.books[i] = writers[i].written();
+    }
+}
+
+void Resharder::copyBorrowRecords(ReshardStats& stats) {
+    // 目標上的 book_id / user_id 與來源不同，透過 qr_code / card_id 重新對應；
+    // seq 保證同一批內依原本的 record_id 順序寫入
+    std::vector<BatchWriter> writers;
+    for (DatabaseConnection* target : targets_) {
+        writers.emplace_back(target->getRawConnection(),
+                             "INSERT INTO borrow_records (book_id, user_id, borrow_date, due_date, return_date) "
+                             "SELECT b.book_id, u.user_id, v.borrow_date, v.due_date, v.return_date FROM (",
+                             " UNION ALL ",
+                             ") v JOIN books b ON b.qr_code = v.qr_code "
+                             "JOIN users u ON u.card_id = v.card_id ORDER BY v.seq",
+                             batch_size_, true);
+    }
+
+    uint64_t seq = 0;
+    for (DatabaseConnection* source : sources_) {
+        streamRows(source->getRawConnection(),
+                   "SELECT b.qr_code, u.card_id, br.borrow_date, br.due_date, br.return_date "
+                   "FROM borrow_records br "
+                   "JOIN books b ON br.book_id = b.book_id "
+                   "JOIN users u ON br.user_id = u.user_id "
+                   "ORDER BY br.record_id",
+                   [&](MYSQL_ROW row) {
+                       std::size_t shard = router_.shardFor(row[0]);
+                       BatchWriter& writer = writers[shard];
+                       MYSQL* conn = writer.connection();
+                       writer.add("SELECT " + std::to_string(seq++) + " AS seq, " +
+                                  quote(conn, row[0]) + " AS qr_code, " +
+                                  quote(conn, row[1]) + " AS card_id, " +
+                                  quote(conn, row[2]) + " AS borrow_date, " +
+                                  quote(conn, row[3]) + " AS due_date, " +
+                                  "CAST(" + quote(conn, row[4]) + " AS DATE) AS return_date");
+                   });
+    }
+    for (std::size_t i = 0; i < writers.size(); ++i) {
+        writers[i].flush();
+        stats.borrow_records[i] = writers[i].written();
+    }
+}
+
+void Resharder::verify(ReshardStats& stats) {
+    for (DatabaseConnection* source : sources_) {
+        MYSQL* conn = source->getRawConnection();
+        stats.source_books += countRows(conn, "SELECT COUNT(*) FROM books");
+        stats.source_borrow_records += countRows(conn, "SELECT COUNT(*) FROM borrow_records");
+    }
+
+    // 使用者複製到每個目標，每個目標都要有完整的一份
+    bool users_ok = true;
+    uint64_t books = 0;
+    uint64_t records = 0;
+    for (DatabaseConnection* target : targets_) {
+        MYSQL* conn = target->getRawConnection();
+        users_ok = users_ok && countRows(conn, "SELECT COUNT(*) FROM users") == stats.source_users;
+        books += countRows(conn, "SELECT COUNT(*) FROM books");
+        records += countRows(conn, "SELECT COUNT(*) FROM borrow_records");
+    }
+    stats.verified = users_ok && books == stats.source_books && records == stats.source_borrow_records;
+}
@@ -0,0 +1,353 @@
+#include "sharded_operations.h"
+#include "async_logger.h"
+#include <algorithm>
+#include <future>
+#include <queue>
+#include <stdexcept>
+
+namespace {
+
+// 各 shard 的結果已經依 less 排好，用 heap 做 k-way merge；
+// 相等時以 shard 編號較小的在前，結果是穩定的
+template <typename T, typename Less>
+std::vector<T> mergeSorted(std::vector<std::vector<T>> runs, Less less) {
+    using Head = std::pair<std::size_t, std::size_t>;   // (run, index)
+    auto after = [&](const Head& a, const Head& b) {
+        const T& x = runs[a.first][a.second];
+        const T& y = runs[b.first][b.second];
+        if (less(y, x)) return true;
+        if (less(x, y)) return false;
+        return a.first > b.first;
+    };
+    std::priority_queue<Head, std::vector<Head>, decltype(after)> heap(after);
+
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < runs.size(); ++i) {
+        total += runs[i].size();
+        if (!runs[i].empty()) {
+            heap.emplace(i, 0);
+        }
+    }
+
+    std::vector<T> merged;
+    merged.reserve(total);
+    while (!heap.empty()) {
+        Head head = heap.top();
+        heap.pop();
+        merged.push_back(std::move(runs[head.first][head.second]));
+        if (head.second + 1 < runs[head.first].size()) {
+            heap.emplace(head.first, head.second + 1);
+        }
+    }
+    return merged;
+}
+
+bool byQrCode(const Book& a, const Book& b) {
+    return a.qr_code < b.qr_code;
+}
+
+bool newerFirst(const BorrowRecord& a, const BorrowRecord& b) {
+    return a.borrow_date > b.borrow_date;
+}
+
+} // namespace
+
+// ---- Routers ----
+
+HashShardRouter::HashShardRouter(std::size_t shard_count)
+    : shard_count_(shard_count) {
+    if (shard_count_ == 0) {
+        throw std::invalid_argument("HashShardRouter needs at least one shard");
+    }
+}
+
+uint64_t HashShardRouter::hash(const std::string& key) {
+    uint64_t h = 14695981039346656037ULL;
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+std::size_t HashShardRouter::shardFor(const std::string& qr_code) const {
+    return static_cast<std::size_t>(hash(qr_code) % shard_count_);
+}
+
+PrefixShardRouter::PrefixShardRouter(std::size_t shard_count)
+    : fallback_(shard_count) {
+}
+
+void PrefixShardRouter::addPrefix(const std::string& prefix, std::size_t shard) {
+    if (shard >= shardCount()) {
+        throw std::invalid_argument("Shard index out of range for prefix " + prefix);
+    }
+    prefixes_.emplace_back(prefix, shard);
+    std::stable_sort(prefixes_.begin(), prefixes_.end(),
+                     [](const auto& a, const auto& b) { return a.first.size() > b.first.size(); });
+}
+
+std::size_t PrefixShardRouter::shardFor(const std::string& qr_code) const {
+    for (const auto& entry : prefixes_) {
+        if (qr_code.compare(0, entry.first.size(), entry.first) == 0) {
+            return entry.second;
+        }
+    }
+    return fallback_.shardFor(qr_code);
+}
+
+// ---- ShardedOperations ----
+
+ShardedOperations::ShardedOperations(std::vector<std::unique_ptr<LibraryStorage>> shards,
+                                     std::unique_ptr<ShardRouter> router)
+    : shards_(std::move(shards))
+    , router_(std::move(router)) {
+    if (shards_.empty() || !router_ || router_->shardCount() != shards_.size()) {
+        throw std::invalid_argument("ShardedOperations: router does not match the shard list");
+    }
+}
+
+template <typename Fn>
+auto ShardedOperations::scatter(Fn fn) -> std::vector<decltype(fn(std::size_t{}))> {
+    using Result = decltype(fn(std::size_t{}));
+
+    // shard 0 在目前的執行緒上跑，其餘各開一條；每個 shard 有自己的連線
+    std::vector<std::future<Result>> pending;
+    pending.reserve(shards_.size() - 1);
+    for (std::size_t i = 1; i < shards_.size(); ++i) {
+        pending.push_back(std::async(std::launch::async, fn, i));
+    }
+
+    std::vector<Result> results;
+    results.reserve(shards_.size());
+    results.push_back(fn(0));
+    for (auto& future : pending) {
+        results.push_back(future.get());
+    }
+    return results;
+}
+
+LibraryStorage& ShardedOperations::bookShard(const std::string& qr_code) {
+    return *shards_[router_->shardFor(qr_code)];
+}
+
+LibraryStorage& ShardedOperations::userReplica(const std::string& card_id) {
+    return *shards_[HashShardRouter::hash(card_id) % shards_.size()];
+}
+
+// Book Operations
+bool ShardedOperations::createBook(const Book& book) {
+    if (book.qr_code.empty()) {
+        AsyncLogger::getInstance().log(LogLevel::Warning, "createBook",
+                                       "Sharded storage needs an explicit qr_code");
+        return false;
+    }
+    return bookShard(book.qr_code).createBook(book);
+}
+
+std::optional<Book> ShardedOperations::getBook(const std::string& qr_code) {
+    return bookShard(qr_code).getBook(qr_code);
+}
+
+std::unordered_map<std::string, std::optional<Book>>
+ShardedOperations::getBooks(const std::vector<std::string>& qr_codes) {
+    std::vector<std::vector<std::string>> keys(shards_.size());
+    for (const auto& qr_code : qr_codes) {
+        keys[router_->shardFor(qr_code)].push_back(qr_code);
+    }
+
+    auto parts = scatter([&](std::size_t i) {
+        return keys[i].empty() ? std::unordered_map<std::string, std::optional<Book>>()
+                               : shards_[i]->getBooks(keys[i]);
+    });
+
+    // 任何一個 shard 失敗就整批失敗，與單機版的約定相同
+    std::unordered_map<std::string, std::optional<Book>> books;
+    for (std::size_t i = 0; i < parts.size(); ++i) {
+        if (parts[i].empty() && !keys[i].empty()) {
+            return {};
+        }
+        books.insert(std::make_move_iterator(parts[i].begin()), std::make_move_iterator(parts[i].end()));
+    }
+    return books;
+}
+
+std::vector<Book> ShardedOperations::getAllBooks() {
+    auto runs = scatter([&](std::size_t i) {
+        std::vector<Book> books = shards_[i]->getAllBooks();
+        // 單機版依 book_id 排序；預設編號下與 qr_code 順序相同，分館前綴則不一定
+        if (!std::is_sorted(books.begin(), books.end(), byQrCode)) {
+            std::sort(books.begin(), books.end(), byQrCode);
+        }
+        return books;
+    });
+    return mergeSorted(std::move(runs), byQrCode);
+}
+
+bool ShardedOperations::updateBook(const Book& book) {
+    return bookShard(book.qr_code).updateBook(book);
+}
+
+UpdateResult ShardedOperations::patchBook(const BookPatch& patch) {
+    return bookShard(patch.qr_code).patchBook(patch);
+}
+
+bool ShardedOperations::deleteBook(const std::string& qr_code) {
+    return bookShard(qr_code).deleteBook(qr_code);
+}
+
+// User Operations
+bool ShardedOperations::createUser(const User& user) {
+    if (user.card_id.empty()) {
+        AsyncLogger::getInstance().log(LogLevel::Warning, "createUser",
+                                       "Sharded storage needs an explicit card_id");
+        return false;
+    }
+
+    auto created = scatter([&](std::size_t i) { return shards_[i]->createUser(user); });
+    if (std::all_of(created.begin(), created.end(), [](bool ok) { return ok; })) {
+        return true;
+    }
+
+    // 部分 shard 失敗：把已建立的刪掉，避免使用者只存在於部分 shard
+    for (std::size_t i = 0; i < shards_.size(); ++i) {
+        if (created[i]) {
+            shards_[i]->deleteUser(user.card_id);
+        }
+    }
+    return false;
+}
+
+std::optional<User> ShardedOperations::getUser(const std::string& card_id) {
+    return userReplica(card_id).getUser(card_id);
+}
+
+std::unordered_map<std::string, std::optional<User>>
+ShardedOperations::getUsers(const std::vector<std::string>& card_ids) {
+    std::vector<std::vector<std::string>> keys(shards_.size());
+    for (const auto& card_id : card_ids) {
+        keys[HashShardRouter::hash(card_id) % shards_.size()].push_back(card_id);
+    }
+
+    auto parts = scatter([&](std::size_t i) {
+        return keys[i].empty() ? std::unordered_map<std::string, std::optional<User>>()
+                               : shards_[i]->getUsers(keys[i]);
+    });
+
+    std::unordered_map<std::string, std::optional<User>> users;
+    for (std::size_t i = 0; i < parts.size(); ++i) {
+        if (parts[i].empty() && !keys[i].empty()) {
+            return {};
+        }
+        users.insert(std::make_move_iterator(parts[i].begin()), std::make_move_iterator(parts[i].end()));
+    }
+    return users;
+}
+
+std::vector<User> ShardedOperations::getAllUsers() {
+    // 每個 shard 都有完整的使用者資料
+    return shards_.front()->getAllUsers();
+}
+
+bool ShardedOperations::updateUser(const User& user) {
+    auto updated = scatter([&](std::size_t i) { return shards_[i]->updateUser(user); });
+    return std::all_of(updated.begin(), updated.end(), [](bool ok) { return ok; });
+}
+
+UpdateResult ShardedOperations::patchUser(const UserPatch& patch) {
+    // 以 shard 0 為準做 compare-and-set；成功後其餘副本不帶 version 條件直接套用，
+    // 避免副本的 version 已經不同時被誤判為衝突
+    UpdateResult result = shards_.front()->patchUser(patch);
+    if (result != UpdateResult::Applied || patch.empty()) {
+        return result;
+    }
+    UserPatch replica_patch = patch;
+    replica_patch.expected_version.reset();
+    auto replicas = scatter([&](std::size_t i) {
+        return i == 0 ? UpdateResult::Applied : shards_[i]->patchUser(replica_patch);
+    });
+
+    std::string failed;
+    for (std::size_t i = 1; i < replicas.size(); ++i) {
+        if (replicas[i] != UpdateResult::Applied) {
+            failed += (failed.empty() ? "" : ", ") + std::to_string(i);
+        }
+    }
+    if (failed.empty()) {
+        return UpdateResult::Applied;
+    }
+    AsyncLogger::getInstance().log(LogLevel::Error, "patchUser",
+                                   "Applied on shard 0 but not on shard(s) " + failed +
+                                   " for " + patch.card_id);
+    return UpdateResult::Partial;
+}
+
+bool ShardedOperations::deleteUser(const std::string& card_id) {
+    // 任何 shard 上有借閱記錄、或有 shard 讀不到，都不能刪，否則會只刪掉一部分
+    auto loans = countUserLoans(card_id, false);
+    if (!loans || *loans > 0) {
+        return false;
+    }
+
+    // 逐一刪除；中途失敗就用各 shard 原本的資料把已刪掉的副本建回來
+    auto copies = scatter([&](std::size_t i) { return shards_[i]->getUser(card_id); });
+    for (std::size_t i = 0; i < shards_.size(); ++i) {
+        if (shards_[i]->deleteUser(card_id)) {
+            continue;
+        }
+        AsyncLogger& logger = AsyncLogger::getInstance();
+        logger.log(LogLevel::Error, "deleteUser",
+                   "Delete failed on shard " + std::to_string(i) + " for " + card_id + "; restoring");
+        for (std::size_t j = 0; j < i; ++j) {
+            if (copies[j] && !shards_[j]->createUser(*copies[j])) {
+                logger.log(LogLevel::Error, "deleteUser",
+                           "Could not restore " + card_id + " on shard " + std::to_string(j));
+            }
+        }
+        return false;
+    }
+    return true;
+}
+
+// Borrow Operations
+bool ShardedOperations::createBorrowRecord(const std::string& book_qr, const std::string& user_card) {
+    // borrow_book 只看得到本機的借閱數，先跨 shard 檢查上限；
+    // 任何 shard 讀不到就不借出，寧可拒絕也不要超過上限
+    if (shards_.size() > 1) {
+        auto active = countUserLoans(user_card, true);
+        if (!active) {
+            AsyncLogger::getInstance().log(LogLevel::Warning, "createBorrowRecord",
+                                           "Could not count open loans for " + user_card);
+            return false;
+        }
+        if (*active >= kMaxActiveLoans) {
+            return false;
+        }
+    }
+    return bookShard(book_qr).createBorrowRecord(book_qr, user_card);
+}
+
+bool ShardedOperations::returnBook(const std::string& book_qr) {
+    return bookShard(book_qr).returnBook(book_qr);
+}
+
+std::vector<BorrowRecord> ShardedOperations::getUserBorrowHistory(const std::string& user_card) {
+    auto runs = scatter([&](std::size_t i) { return shards_[i]->getUserBorrowHistory(user_card); });
+    return mergeSorted(std::move(runs), newerFirst);
+}
+
+std::vector<BorrowRecord> ShardedOperations::getBookBorrowHistory(const std::string& book_qr) {
+    return bookShard(book_qr).getBookBorrowHistory(book_qr);
+}
+
+std::optional<std::size_t> ShardedOperations::countUserLoans(const std::string& user_card, bool open_only) {
+    auto counts = scatter([&](std::size_t i) { return shards_[i]->countUserLoans(user_card, open_only); });
+    std::size_t total = 0;
+    for (const auto& count : counts) {
+        if (!count) {
+            return std::nullopt;
+        }
+        total += *count;
+    }
+    return total;
+}
@@ -0,0 +1,128 @@
+#ifndef ID_WATERMARK_H
+#define ID_WATERMARK_H
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// Tracks which rows of an AUTO_INCREMENT table an incremental reader has
+// already consumed.
+//
+// A plain "id > last seen" cursor loses rows: ids are assigned when a row
+// is inserted, not when its transaction commits, so with concurrent
+// writers a lower id can become visible after a higher one was read. The
+// watermark therefore remembers the holes below its high-water mark as
+// gaps and keeps re-reading them until they fill in, age out (the
+// transaction rolled back) or fall out of the trailing window.
+//
+// Usage per pass:
+//   SELECT ... WHERE <pendingCondition("id")>
+//   advance(ids that were read, now);
+//   expire(now, max_age, window);
+// Every row matched by pendingCondition() is unseen, so callers can apply
+// all of them without de-duplication.
+class IdWatermark {
+public:
+    struct Gap {
+        long long first;        // inclusive
+        long long last;         // inclusive
+        long long opened_at;    // caller's clock, e.g. seconds since epoch
+    };
+
+    static constexpr long long kDefaultWindow = 100000;     // ids
+    static constexpr long long kDefaultMaxGapAge = 600;     // seconds
+
+    IdWatermark() = default;
+    explicit IdWatermark(long long high_water) : high_water_(high_water) {}
+
+    long long highWater() const { return high_water_; }
+    const std::vector<Gap>& gaps() const { return gaps_; }
+
+    // For persistence: restores a state previously read through
+    // highWater() and gaps().
+    void restore(long long high_water, std::vector<Gap> gaps) {
+        high_water_ = high_water;
+        gaps_ = std::move(gaps);
+        std::sort(gaps_.begin(), gaps_.end(),
+                  [](const Gap& a, const Gap& b) { return a.first < b.first; });
+    }
+
+    // "(col BETWEEN a AND b OR ...)", or an empty string without gaps
+    std::string gapCondition(const std::string& column) const {
+        if (gaps_.empty()) {
+            return std::string();
+        }
+        std::string condition = "(";
+        for (std::size_t i = 0; i < gaps_.size(); ++i) {
+            condition += (i == 0 ? "" : " OR ") + column + " BETWEEN " +
+                         std::to_string(gaps_[i].first) + " AND " + std::to_string(gaps_[i].last);
+        }
+        return condition + ")";
+    }
+
+    // Matches every row that has not been consumed yet
+    std::string pendingCondition(const std::string& column) const {
+        std::string above = column + " > " + std::to_string(high_water_);
+        if (gaps_.empty()) {
+            return above;
+        }
+        return "(" + above + " OR " + gapCondition(column) + ")";
+    }
+
+    // Records the ids returned by a read of pendingCondition(), in any
+    // order. Ids inside a gap close it; ids above the high-water mark
+    // raise it and open gaps for the ids skipped on the way.
+    void advance(std::vector<long long> ids, long long now) {
+        std::sort(ids.begin(), ids.end());
+        for (long long id : ids) {
+            if (id > high_water_) {
+                if (id > high_water_ + 1) {
+                    gaps_.push_back(Gap{high_water_ + 1, id - 1, now});
+                }
+                high_water_ = id;
+                continue;
+            }
+            fill(id);
+        }
+    }
+
+    // Gives up on gaps opened more than max_age ago or lying entirely
+    // below highWater() - window; returns how many were dropped.
+    std::size_t expire(long long now, long long max_age, long long window) {
+        std::size_t before = gaps_.size();
+        long long floor = high_water_ - window;
+        gaps_.erase(std::remove_if(gaps_.begin(), gaps_.end(),
+                                   [&](const Gap& gap) {
+                                       return now - gap.opened_at > max_age || gap.last <= floor;
+                                   }),
+                    gaps_.end());
+        return before - gaps_.size();
+    }
+
+private:
+    // gaps_ is sorted by first and non-overlapping
+    void fill(long long id) {
+        auto it = std::upper_bound(gaps_.begin(), gaps_.end(), id,
+                                   [](long long value, const Gap& gap) { return value < gap.first; });
+        if (it == gaps_.begin()) {
+            return;
+        }
+        --it;
+        if (id > it->last) {
+            return;
+        }
+        Gap gap = *it;
+        it = gaps_.erase(it);
+        if (id < gap.last) {
+            it = gaps_.insert(it, Gap{id + 1, gap.last, gap.opened_at});
+        }
+        if (gap.first < id) {
+            gaps_.insert(it, Gap{gap.first, id - 1, gap.opened_at});
+        }
+    }
+
+    long long high_water_ = 0;
+    std::vector<Gap> gaps_;
+};
+
+#endif // ID_WATERMARK_H
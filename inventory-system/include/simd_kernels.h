@@ -0,0 +1,36 @@
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Column kernels used by StockSnapshot. Each has an AVX2 path, chosen at
+// run time when the CPU supports it (x86 with GCC or Clang), and a scalar
+// fallback. The integer kernels return
+// identical results on both paths; the double kernels add in a different
+// order (four lanes, then a horizontal sum), so their results may differ
+// from the scalar path in the last bits.
+namespace simd {
+
+// Sum of values[i] for every i where keys[i] == key.
+int64_t sumWhereEqual(const int32_t* keys, const int32_t* values, std::size_t n, int32_t key);
+
+// Sum of values[i] * weights[i].
+double weightedSum(const int32_t* values, const double* weights, std::size_t n);
+
+// Same as weightedSum, restricted to rows where keys[i] == key.
+double weightedSumWhereEqual(const int32_t* keys, const int32_t* values,
+                             const double* weights, std::size_t n, int32_t key);
+
+// Appends every i where values[i] < limits[i] to out.
+void selectLess(const int32_t* values, const int32_t* limits, std::size_t n,
+                std::vector<uint32_t>& out);
+
+// Appends every i where values[i] < limit to out.
+void selectLessThan(const int32_t* values, int32_t limit, std::size_t n,
+                    std::vector<uint32_t>& out);
+
+} // namespace simd
+
+#endif // SIMD_KERNELS_H
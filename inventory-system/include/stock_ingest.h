@@ -0,0 +1,79 @@
+#ifndef STOCK_INGEST_H
+#define STOCK_INGEST_H
+
+#include <cstddef>
+#include <ctime>
+#include <istream>
+#include <string>
+#include <vector>
+
+struct StockMovement {
+    int sku_id;
+    int warehouse_id;
+    int qty_delta;
+    double unit_cost;
+    std::string movement_type;
+    std::tm moved_at;
+};
+
+// One batch of movements stored column by column; a worker turns it into
+// multi-row INSERT statements inside one transaction.
+struct MovementBatch {
+    std::vector<int> sku_ids;
+    std::vector<int> warehouse_ids;
+    std::vector<int> qty_deltas;
+    std::vector<double> unit_costs;
+    std::vector<std::string> movement_types;
+    std::vector<std::tm> moved_at;
+
+    void reserve(std::size_t n);
+    void clear();
+    void push_back(const StockMovement& movement);
+    std::size_t size() const { return sku_ids.size(); }
+    bool empty() const { return sku_ids.empty(); }
+};
+
+struct IngestOptions {
+    std::string connect_string;
+    std::size_t batch_size = 10000;   // rows per transaction
+    std::size_t worker_count = 4;     // one SOCI session per worker
+    std::size_t queue_depth = 8;      // parsed batches waiting for a worker
+};
+
+struct IngestStats {
+    std::size_t rows_read = 0;
+    std::size_t rows_inserted = 0;
+    std::size_t rows_rejected = 0;    // malformed lines and failed batches
+    std::size_t batches = 0;
+    double seconds = 0.0;
+    // Every worker failed; the remaining input was read and counted as
+    // rejected, so rows_inserted is only part of the file.
+    bool aborted = false;
+
+    double rowsPerSecond() const { return seconds > 0.0 ? rows_inserted / seconds : 0.0; }
+};
+
+// Streams movement files into stock_movements.
+//
+// Line format (CSV, '#' starts a comment, a non-numeric first line is
+// treated as a header):
+//   sku_id,warehouse_id,qty_delta,unit_cost,movement_type,YYYY-MM-DD HH:MM:SS
+//
+// The calling thread parses the input into column batches; a small pool of
+// workers, each with its own session, inserts them. The SOCI MySQL backend
+// sends a bound vector one row per round trip, so each batch is written as
+// multi-row INSERT ... VALUES statements of at most about 1 MB instead.
+class StockIngest {
+public:
+    explicit StockIngest(IngestOptions options);
+
+    IngestStats ingestFile(const std::string& path);
+    IngestStats ingestStream(std::istream& in);
+
+    static bool parseLine(const std::string& line, StockMovement& out);
+
+private:
+    IngestOptions options_;
+};
+
+#endif // STOCK_INGEST_H
@@ -0,0 +1,94 @@
+#ifndef STOCK_SNAPSHOT_H
+#define STOCK_SNAPSHOT_H
+
+#include "id_watermark.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace soci {
+class session;
+}
+
+struct StockLevel {
+    int sku_id;
+    int warehouse_id;
+    int on_hand;
+    int reorder_point;
+    double unit_cost;
+};
+
+// In-memory on-hand stock, one row per (sku, warehouse), stored as a
+// structure of arrays so dashboard queries run as tight column scans
+// (see simd_kernels.h) instead of GROUP BY queries against MySQL.
+//
+// load() aggregates stock_movements once; refresh() then applies only the
+// movements it has not seen. movement_id is assigned at insert time, so a
+// movement can commit after a higher one was already read; the ids skipped
+// below the high-water mark are kept as gaps (see IdWatermark) and re-read
+// by refresh() until they show up, are older than max_gap_age seconds or
+// fall more than gap_window ids behind. Queries may run concurrently with
+// refresh().
+class StockSnapshot {
+public:
+    explicit StockSnapshot(std::size_t fetch_size = 10000,
+                           long long gap_window = IdWatermark::kDefaultWindow,
+                           long long max_gap_age = IdWatermark::kDefaultMaxGapAge);
+
+    // Rebuilds the snapshot from skus and stock_movements.
+    void load(soci::session& sql);
+    // Applies movements committed since the last load/refresh; returns how many.
+    std::size_t refresh(soci::session& sql);
+
+    int64_t totalForSku(int sku_id) const;
+    int64_t totalForWarehouse(int warehouse_id) const;
+    double valuation() const;
+    double valuationForWarehouse(int warehouse_id) const;
+    // Rows whose on-hand quantity is below the SKU's reorder point.
+    std::vector<StockLevel> lowStock() const;
+    // Rows whose on-hand quantity is below a fixed threshold.
+    std::vector<StockLevel> lowStock(int threshold) const;
+
+    std::size_t rowCount() const;
+    long long lastMovementId() const;
+    // Ranges of movement ids below lastMovementId() still being watched.
+    std::size_t openGaps() const;
+
+private:
+    struct SkuInfo {
+        double unit_cost;
+        int reorder_point;
+    };
+
+    static uint64_t rowKey(int sku_id, int warehouse_id) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(sku_id)) << 32) |
+               static_cast<uint32_t>(warehouse_id);
+    }
+
+    void applyLocked(int sku_id, int warehouse_id, int qty_delta);
+    std::vector<StockLevel> collect(const std::vector<uint32_t>& rows) const;
+
+    std::size_t fetch_size_;
+    long long gap_window_;
+    long long max_gap_age_;
+
+    // Columns, all the same length
+    std::vector<int32_t> sku_ids_;
+    std::vector<int32_t> warehouse_ids_;
+    std::vector<int32_t> on_hand_;
+    std::vector<int32_t> reorder_points_;
+    std::vector<double> unit_costs_;
+
+    std::unordered_map<uint64_t, uint32_t> row_index_;
+    std::unordered_map<int, SkuInfo> sku_info_;
+    IdWatermark watermark_;
+
+    mutable std::shared_mutex mutex_;   // guards the columns for readers
+    std::mutex refresh_mutex_;          // serializes load() / refresh()
+};
+
+#endif // STOCK_SNAPSHOT_H
@@ -1,20 +1,127 @@
 #include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
 #include <soci/soci.h>
 #include <soci/mysql/soci-mysql.h>
+#include "stock_ingest.h"
+#include "stock_snapshot.h"
+
+namespace {
+
+const char* kConnectString = "db=inventory user=your_user password=your_password";
+
+void printUsage(const char* prog) {
+    std::cerr << "Usage: " << prog
+              << " [--workers N] [--batch N] <movement_file>...\n"
+              << "       " << prog << " --report [warehouse_id]...\n";
+}
+
+template <typename F>
+long long elapsedMicros(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+void printReport(soci::session& sql, const std::vector<int>& warehouses) {
+    StockSnapshot snapshot;
+    long long load_us = elapsedMicros([&] { snapshot.load(sql); });
+    std::cout << "Snapshot loaded: " << snapshot.rowCount() << " rows up to movement "
+              << snapshot.lastMovementId() << ", " << snapshot.openGaps() << " open gaps ("
+              << load_us << " us)" << std::endl;
+
+    double total = 0.0;
+    long long valuation_us = elapsedMicros([&] { total = snapshot.valuation(); });
+    std::cout << "Total valuation: " << total << " (" << valuation_us << " us)" << std::endl;
+
+    for (int warehouse_id : warehouses) {
+        int64_t on_hand = 0;
+        double value = 0.0;
+        long long query_us = elapsedMicros([&] {
+            on_hand = snapshot.totalForWarehouse(warehouse_id);
+            value = snapshot.valuationForWarehouse(warehouse_id);
+        });
+        std::cout << "Warehouse " << warehouse_id << ": on hand " << on_hand
+                  << ", valuation " << value << " (" << query_us << " us)" << std::endl;
+    }
+
+    std::vector<StockLevel> low;
+    long long low_us = elapsedMicros([&] { low = snapshot.lowStock(); });
+    std::cout << "Below reorder point: " << low.size() << " rows (" << low_us << " us)" << std::endl;
+    for (const auto& level : low) {
+        std::cout << "  sku " << level.sku_id << " @ warehouse " << level.warehouse_id
+                  << ": " << level.on_hand << " / " << level.reorder_point << std::endl;
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    IngestOptions options;
+    options.connect_string = kConnectString;
+    std::vector<std::string> files;
+    bool report = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--report") == 0) {
+            report = true;
+        } else if (std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            options.worker_count = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            options.batch_size = std::strtoul(argv[++i], nullptr, 10);
+        } else if (argv[i][0] == '-') {
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
 
-int main() {
     try {
-        // 建立連接
-        soci::session sql(soci::mysql, 
-            "db=inventory user=your_user password=your_password");
-        
-        std::cout << "Successfully connected to database!" << std::endl;
-        
+        if (report) {
+            std::vector<int> warehouses;
+            for (const auto& arg : files) {
+                warehouses.push_back(std::atoi(arg.c_str()));
+            }
+            soci::session sql(soci::mysql, options.connect_string);
+            printReport(sql, warehouses);
+            return 0;
+        }
+
+        if (files.empty()) {
+            // 沒有指定檔案時只測試連線
+            soci::session sql(soci::mysql, options.connect_string);
+            std::cout << "Successfully connected to database!" << std::endl;
+            return 0;
+        }
+
+        StockIngest ingest(options);
+        for (const auto& file : files) {
+            IngestStats stats = ingest.ingestFile(file);
+            std::cout << file << ": "
+                      << stats.rows_inserted << " rows inserted, "
+                      << stats.rows_rejected << " rejected, "
+                      << stats.batches << " batches in "
+                      << stats.seconds << " s ("
+                      << static_cast<long long>(stats.rowsPerSecond()) << " rows/sec)"
+                      << std::endl;
+            if (stats.aborted) {
+                std::cerr << file << ": aborted, every ingest worker failed" << std::endl;
+                return 1;
+            }
+        }
+
     } catch (const soci::mysql_soci_error& e) {
         std::cerr << "MySQL error: " << e.what() << std::endl;
+        return 1;
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
     }
     
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,251 @@
+#include "simd_kernels.h"
+
+// AVX2 版本以 target attribute 編譯，執行時才依 CPU 選擇，
+// 不需要 -march=native，舊 CPU 上也不會 SIGILL
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_HAVE_AVX2 1
+#define AVX2_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#else
+#define SIMD_HAVE_AVX2 0
+#endif
+
+namespace simd {
+namespace {
+
+namespace scalar {
+
+int64_t sumWhereEqual(const int32_t* keys, const int32_t* values, std::size_t n, int32_t key) {
+    int64_t total = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        total += (keys[i] == key) ? values[i] : 0;
+    }
+    return total;
+}
+
+double weightedSum(const int32_t* values, const double* weights, std::size_t n) {
+    double total = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        total += values[i] * weights[i];
+    }
+    return total;
+}
+
+double weightedSumWhereEqual(const int32_t* keys, const int32_t* values,
+                             const double* weights, std::size_t n, int32_t key) {
+    double total = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        total += (keys[i] == key) ? values[i] * weights[i] : 0.0;
+    }
+    return total;
+}
+
+void selectLess(const int32_t* values, const int32_t* limits, std::size_t n,
+                std::vector<uint32_t>& out) {
+    for (std::size_t i = 0; i < n; ++i) {
+        if (values[i] < limits[i]) {
+            out.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+void selectLessThan(const int32_t* values, int32_t limit, std::size_t n,
+                    std::vector<uint32_t>& out) {
+    for (std::size_t i = 0; i < n; ++i) {
+        if (values[i] < limit) {
+            out.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+} // namespace scalar
+
+#if SIMD_HAVE_AVX2
+
+bool useAvx2() {
+    static const bool supported = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+    }();
+    return supported;
+}
+
+namespace avx2 {
+
+// 把 8 個 int32 擴展成 int64 後累加，避免大量庫存加總時溢位
+AVX2_TARGET inline __m256i addWidened(__m256i acc, __m256i v) {
+    __m256i lo = _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v));
+    __m256i hi = _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1));
+    return _mm256_add_epi64(acc, _mm256_add_epi64(lo, hi));
+}
+
+AVX2_TARGET inline int64_t horizontalSum(__m256i v) {
+    alignas(32) int64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), v);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+AVX2_TARGET inline double horizontalSum(__m256d v) {
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, v);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+// 8 筆 int32 乘上 8 筆 double，分成兩組 4 lanes 計算
+AVX2_TARGET inline __m256d accumulateProducts(__m256d acc, __m256i values, const double* weights) {
+    __m256d lo = _mm256_cvtepi32_pd(_mm256_castsi256_si128(values));
+    __m256d hi = _mm256_cvtepi32_pd(_mm256_extracti128_si256(values, 1));
+    acc = _mm256_add_pd(acc, _mm256_mul_pd(lo, _mm256_loadu_pd(weights)));
+    return _mm256_add_pd(acc, _mm256_mul_pd(hi, _mm256_loadu_pd(weights + 4)));
+}
+
+AVX2_TARGET inline void appendMask(unsigned mask, std::size_t base, std::vector<uint32_t>& out) {
+    while (mask) {
+        unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+        out.push_back(static_cast<uint32_t>(base + bit));
+        mask &= mask - 1;
+    }
+}
+
+AVX2_TARGET int64_t sumWhereEqual(const int32_t* keys, const int32_t* values, std::size_t n, int32_t key) {
+    const __m256i needle = _mm256_set1_epi32(key);
+    __m256i acc = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        acc = addWidened(acc, _mm256_and_si256(_mm256_cmpeq_epi32(k, needle), v));
+    }
+    int64_t total = horizontalSum(acc);
+    for (; i < n; ++i) {
+        if (keys[i] == key) {
+            total += values[i];
+        }
+    }
+    return total;
+}
+
+AVX2_TARGET double weightedSum(const int32_t* values, const double* weights, std::size_t n) {
+    __m256d acc = _mm256_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        acc = accumulateProducts(acc, v, weights + i);
+    }
+    double total = horizontalSum(acc);
+    for (; i < n; ++i) {
+        total += values[i] * weights[i];
+    }
+    return total;
+}
+
+AVX2_TARGET double weightedSumWhereEqual(const int32_t* keys, const int32_t* values,
+                             const double* weights, std::size_t n, int32_t key) {
+    const __m256i needle = _mm256_set1_epi32(key);
+    __m256d acc = _mm256_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        acc = accumulateProducts(acc, _mm256_and_si256(_mm256_cmpeq_epi32(k, needle), v), weights + i);
+    }
+    double total = horizontalSum(acc);
+    for (; i < n; ++i) {
+        if (keys[i] == key) {
+            total += values[i] * weights[i];
+        }
+    }
+    return total;
+}
+
+AVX2_TARGET void selectLess(const int32_t* values, const int32_t* limits, std::size_t n,
+                std::vector<uint32_t>& out) {
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        __m256i l = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(limits + i));
+        unsigned mask = static_cast<unsigned>(
+            _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(l, v))));
+        appendMask(mask, i, out);
+    }
+    for (; i < n; ++i) {
+        if (values[i] < limits[i]) {
+            out.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+AVX2_TARGET void selectLessThan(const int32_t* values, int32_t limit, std::size_t n,
+                    std::vector<uint32_t>& out) {
+    const __m256i l = _mm256_set1_epi32(limit);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        unsigned mask = static_cast<unsigned>(
+            _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(l, v))));
+        appendMask(mask, i, out);
+    }
+    for (; i < n; ++i) {
+        if (values[i] < limit) {
+            out.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+} // namespace avx2
+
+#endif // SIMD_HAVE_AVX2
+
+} // namespace
+
+int64_t sumWhereEqual(const int32_t* keys, const int32_t* values, std::size_t n, int32_t key) {
+#if SIMD_HAVE_AVX2
+    if (useAvx2()) {
+        return avx2::sumWhereEqual(keys, values, n, key);
+    }
+#endif
+    return scalar::sumWhereEqual(keys, values, n, key);
+}
+
+double weightedSum(const int32_t* values, const double* weights, std::size_t n) {
+#if SIMD_HAVE_AVX2
+    if (useAvx2()) {
+        return avx2::weightedSum(values, weights, n);
+    }
+#endif
+    return scalar::weightedSum(values, weights, n);
+}
+
+double weightedSumWhereEqual(const int32_t* keys, const int32_t* values,
+                             const double* weights, std::size_t n, int32_t key) {
+#if SIMD_HAVE_AVX2
+    if (useAvx2()) {
+        return avx2::weightedSumWhereEqual(keys, values, weights, n, key);
+    }
+#endif
+    return scalar::weightedSumWhereEqual(keys, values, weights, n, key);
+}
+
+void selectLess(const int32_t* values, const int32_t* limits, std::size_t n,
+                std::vector<uint32_t>& out) {
+#if SIMD_HAVE_AVX2
+    if (useAvx2()) {
+        avx2::selectLess(values, limits, n, out);
+        return;
+    }
+#endif
+    scalar::selectLess(values, limits, n, out);
+}
+
+void selectLessThan(const int32_t* values, int32_t limit, std::size_t n,
+                    std::vector<uint32_t>& out) {
+#if SIMD_HAVE_AVX2
+    if (useAvx2()) {
+        avx2::selectLessThan(values, limit, n, out);
+        return;
+    }
+#endif
+    scalar::selectLessThan(values, limit, n, out);
+}
+
+} // namespace simd
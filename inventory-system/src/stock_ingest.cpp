@@ -0,0 +1,318 @@
+#include "stock_ingest.h"
+
+#include <soci/soci.h>
+#include <soci/mysql/soci-mysql.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+// 讀取執行緒與寫入執行緒之間的有界佇列，佇列滿時讀取端會等待，記憶體用量固定
+class BatchQueue {
+public:
+    BatchQueue(std::size_t capacity, std::size_t consumers)
+        : capacity_(capacity), consumers_(consumers) {}
+
+    // 所有 worker 都已結束時回傳 false，batch 保持不動，由呼叫端計為失敗
+    bool push(MovementBatch&& batch) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this] { return queue_.size() < capacity_ || consumers_ == 0; });
+        if (consumers_ == 0) {
+            return false;
+        }
+        queue_.push_back(std::move(batch));
+        not_empty_.notify_one();
+        return true;
+    }
+
+    // 佇列關閉且清空後回傳 false
+    bool pop(MovementBatch& batch) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return closed_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            return false;
+        }
+        batch = std::move(queue_.front());
+        queue_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+    }
+
+    // worker 結束時呼叫；最後一個 worker 離開後讀取端不再等待
+    void consumerDone() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--consumers_ == 0) {
+            not_full_.notify_all();
+        }
+    }
+
+private:
+    std::size_t capacity_;
+    std::size_t consumers_;
+    std::deque<MovementBatch> queue_;
+    bool closed_ = false;
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+};
+
+bool parseInt(const char*& p, int& out) {
+    char* end = nullptr;
+    long value = std::strtol(p, &end, 10);
+    if (end == p || *end != ',') {
+        return false;
+    }
+    out = static_cast<int>(value);
+    p = end + 1;
+    return true;
+}
+
+bool isMovementType(const std::string& type) {
+    return type == "receipt" || type == "issue" || type == "transfer_in" ||
+           type == "transfer_out" || type == "adjustment";
+}
+
+const char* const kInsertHead =
+    "INSERT INTO stock_movements "
+    "(sku_id, warehouse_id, qty_delta, unit_cost, movement_type, moved_at) VALUES ";
+
+// 單一語句的上限，遠低於 max_allowed_packet
+constexpr std::size_t kMaxStatementBytes = 1024 * 1024;
+
+// movement_type 已經過白名單檢查，其餘都是數字，不需要跳脫
+void appendRow(std::string& query, const MovementBatch& batch, std::size_t i) {
+    const std::tm& t = batch.moved_at[i];
+    char row[160];
+    int n = std::snprintf(row, sizeof(row),
+                          "(%d, %d, %d, %.17g, '%s', '%04d-%02d-%02d %02d:%02d:%02d')",
+                          batch.sku_ids[i], batch.warehouse_ids[i], batch.qty_deltas[i],
+                          batch.unit_costs[i], batch.movement_types[i].c_str(),
+                          t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec);
+    query.append(row, static_cast<std::size_t>(n) < sizeof(row) ? n : sizeof(row) - 1);
+}
+
+} // namespace
+
+void MovementBatch::reserve(std::size_t n) {
+    sku_ids.reserve(n);
+    warehouse_ids.reserve(n);
+    qty_deltas.reserve(n);
+    unit_costs.reserve(n);
+    movement_types.reserve(n);
+    moved_at.reserve(n);
+}
+
+void MovementBatch::clear() {
+    sku_ids.clear();
+    warehouse_ids.clear();
+    qty_deltas.clear();
+    unit_costs.clear();
+    movement_types.clear();
+    moved_at.clear();
+}
+
+void MovementBatch::push_back(const StockMovement& movement) {
+    sku_ids.push_back(movement.sku_id);
+    warehouse_ids.push_back(movement.warehouse_id);
+    qty_deltas.push_back(movement.qty_delta);
+    unit_costs.push_back(movement.unit_cost);
+    movement_types.push_back(movement.movement_type);
+    moved_at.push_back(movement.moved_at);
+}
+
+StockIngest::StockIngest(IngestOptions options)
+    : options_(std::move(options)) {
+    if (options_.batch_size == 0 || options_.worker_count == 0 || options_.queue_depth == 0) {
+        throw std::invalid_argument("batch_size, worker_count and queue_depth must be positive");
+    }
+}
+
+bool StockIngest::parseLine(const std::string& line, StockMovement& out) {
+    const char* p = line.c_str();
+    if (!parseInt(p, out.sku_id) || !parseInt(p, out.warehouse_id) || !parseInt(p, out.qty_delta)) {
+        return false;
+    }
+
+    char* end = nullptr;
+    out.unit_cost = std::strtod(p, &end);
+    if (end == p || *end != ',') {
+        return false;
+    }
+    p = end + 1;
+
+    const char* comma = std::strchr(p, ',');
+    if (!comma) {
+        return false;
+    }
+    out.movement_type.assign(p, comma);
+    if (!isMovementType(out.movement_type)) {
+        return false;
+    }
+    p = comma + 1;
+
+    std::memset(&out.moved_at, 0, sizeof(out.moved_at));
+    std::tm& t = out.moved_at;
+    if (std::sscanf(p, "%d-%d-%d %d:%d:%d",
+                    &t.tm_year, &t.tm_mon, &t.tm_mday,
+                    &t.tm_hour, &t.tm_min, &t.tm_sec) != 6) {
+        return false;
+    }
+    t.tm_year -= 1900;
+    t.tm_mon -= 1;
+    return true;
+}
+
+IngestStats StockIngest::ingestFile(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Cannot open movement file: " + path);
+    }
+    return ingestStream(in);
+}
+
+IngestStats StockIngest::ingestStream(std::istream& in) {
+    IngestStats stats;
+    std::atomic<std::size_t> inserted{0};
+    std::atomic<std::size_t> failed{0};
+    std::atomic<std::size_t> batches{0};
+    BatchQueue queue(options_.queue_depth, options_.worker_count);
+
+    auto start = std::chrono::steady_clock::now();
+
+    // 連線先在呼叫端建立好，連不上就直接拋出例外，不會開始讀檔
+    std::vector<std::unique_ptr<soci::session>> sessions;
+    for (std::size_t i = 0; i < options_.worker_count; ++i) {
+        sessions.push_back(std::make_unique<soci::session>(soci::mysql, options_.connect_string));
+    }
+
+    std::vector<std::thread> workers;
+    for (auto& session : sessions) {
+        workers.emplace_back([&, sql_ptr = session.get()] {
+            soci::session& sql = *sql_ptr;
+            MovementBatch batch;
+            std::string query;
+            try {
+                while (queue.pop(batch)) {
+                    // 整批放在同一個 transaction；每條語句帶多列資料，一次 round trip 寫入上千筆
+                    try {
+                        soci::transaction tr(sql);
+                        std::size_t i = 0;
+                        while (i < batch.size()) {
+                            query.assign(kInsertHead);
+                            std::size_t head = query.size();
+                            for (; i < batch.size() && query.size() < kMaxStatementBytes; ++i) {
+                                if (query.size() > head) {
+                                    query += ", ";
+                                }
+                                appendRow(query, batch, i);
+                            }
+                            sql << query;
+                        }
+                        tr.commit();
+                        inserted += batch.size();
+                        ++batches;
+                    } catch (const soci::soci_error& e) {
+                        std::cerr << "Batch insert failed (" << batch.size() << " rows): "
+                                  << e.what() << std::endl;
+                        failed += batch.size();
+                    }
+                }
+            } catch (const std::exception& e) {
+                // 只有這個 worker 退出，佇列裡的資料留給其他 worker 寫入
+                std::cerr << "Ingest worker failed: " << e.what() << std::endl;
+            }
+            queue.consumerDone();
+        });
+    }
+
+    MovementBatch batch;
+    batch.reserve(options_.batch_size);
+    StockMovement movement;
+    std::string line;
+    bool first_line = true;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        ++stats.rows_read;
+        if (!parseLine(line, movement)) {
+            // 第一行若不是數字開頭，視為標題列
+            if (first_line && !(line[0] >= '0' && line[0] <= '9')) {
+                --stats.rows_read;
+            } else {
+                ++stats.rows_rejected;
+            }
+            first_line = false;
+            continue;
+        }
+        first_line = false;
+
+        batch.push_back(movement);
+        if (batch.size() >= options_.batch_size) {
+            if (!queue.push(std::move(batch))) {
+                stats.aborted = true;  // 所有 worker 都失敗了，剩下的資料不會再寫入
+                break;
+            }
+            batch = MovementBatch();
+            batch.reserve(options_.batch_size);
+        }
+    }
+    if (stats.aborted) {
+        // 把檔案讀完並計為 rejected，統計才涵蓋整個檔案
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (!line.empty() && line[0] != '#') {
+                ++stats.rows_read;
+                ++stats.rows_rejected;
+            }
+        }
+    }
+    if (!batch.empty() && !stats.aborted) {
+        if (queue.push(std::move(batch))) {
+            batch = MovementBatch();
+        } else {
+            stats.aborted = true;
+        }
+    }
+    failed += batch.size();
+    queue.close();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // 只有全部 worker 都提早退出時佇列才會有剩下的資料
+    while (queue.pop(batch)) {
+        failed += batch.size();
+        stats.aborted = true;
+    }
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats.rows_inserted = inserted;
+    stats.rows_rejected += failed;
+    stats.batches = batches;
+    return stats;
+}
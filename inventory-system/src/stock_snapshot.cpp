@@ -0,0 +1,228 @@
+#include "stock_snapshot.h"
+#include "simd_kernels.h"
+
+#include <soci/soci.h>
+
+#include <algorithm>
+#include <ctime>
+#include <mutex>
+#include <string>
+
+StockSnapshot::StockSnapshot(std::size_t fetch_size, long long gap_window, long long max_gap_age)
+    : fetch_size_(fetch_size == 0 ? 1 : fetch_size)
+    , gap_window_(gap_window < 0 ? 0 : gap_window)
+    , max_gap_age_(max_gap_age < 0 ? 0 : max_gap_age) {}
+
+void StockSnapshot::load(soci::session& sql) {
+    std::lock_guard<std::mutex> refresh_lock(refresh_mutex_);
+
+    // 所有讀取都在同一個 InnoDB 快照內，彙總與 high-water mark 才會一致
+    soci::transaction tr(sql);
+
+    // 1. SKU 成本與安全庫存
+    std::unordered_map<int, SkuInfo> sku_info;
+    {
+        std::vector<int> ids(fetch_size_);
+        std::vector<double> costs(fetch_size_);
+        std::vector<int> reorder(fetch_size_);
+        soci::statement st = (sql.prepare <<
+            "SELECT sku_id, unit_cost, reorder_point FROM skus",
+            soci::into(ids), soci::into(costs), soci::into(reorder));
+        st.execute();
+        while (st.fetch()) {
+            for (std::size_t i = 0; i < ids.size(); ++i) {
+                sku_info[ids[i]] = SkuInfo{costs[i], reorder[i]};
+            }
+            ids.resize(fetch_size_);
+            costs.resize(fetch_size_);
+            reorder.resize(fetch_size_);
+        }
+    }
+
+    // 2. 先固定 high-water mark，之後的異動交給 refresh()；
+    //    快照裡 high-water mark 以下缺的編號可能是尚未 commit 的交易，記成 gap
+    long long high_water = 0;
+    sql << "SELECT COALESCE(MAX(movement_id), 0) FROM stock_movements", soci::into(high_water);
+
+    IdWatermark watermark(std::max(0LL, high_water - gap_window_));
+    {
+        long long window_start = watermark.highWater();
+        std::vector<long long> seen;
+        std::vector<long long> ids(fetch_size_);
+        soci::statement st = (sql.prepare <<
+            "SELECT movement_id FROM stock_movements "
+            "WHERE movement_id > :window_start AND movement_id <= :high_water",
+            soci::into(ids), soci::use(window_start), soci::use(high_water));
+        st.execute();
+        while (st.fetch()) {
+            seen.insert(seen.end(), ids.begin(), ids.end());
+            ids.resize(fetch_size_);
+        }
+        watermark.advance(std::move(seen), static_cast<long long>(std::time(nullptr)));
+    }
+
+    // 3. 依 (sku, warehouse) 彙總現有庫存
+    std::vector<int32_t> sku_ids, warehouse_ids, on_hand, reorder_points;
+    std::vector<double> unit_costs;
+    std::unordered_map<uint64_t, uint32_t> row_index;
+    {
+        std::vector<int> skus(fetch_size_);
+        std::vector<int> warehouses(fetch_size_);
+        std::vector<long long> totals(fetch_size_);
+        soci::statement st = (sql.prepare <<
+            "SELECT sku_id, warehouse_id, CAST(SUM(qty_delta) AS SIGNED) "
+            "FROM stock_movements "
+            "WHERE movement_id <= :high_water "
+            "GROUP BY sku_id, warehouse_id",
+            soci::into(skus), soci::into(warehouses), soci::into(totals),
+            soci::use(high_water));
+        st.execute();
+        while (st.fetch()) {
+            for (std::size_t i = 0; i < skus.size(); ++i) {
+                auto info = sku_info.find(skus[i]);
+                row_index[rowKey(skus[i], warehouses[i])] = static_cast<uint32_t>(sku_ids.size());
+                sku_ids.push_back(skus[i]);
+                warehouse_ids.push_back(warehouses[i]);
+                on_hand.push_back(static_cast<int32_t>(totals[i]));
+                reorder_points.push_back(info != sku_info.end() ? info->second.reorder_point : 0);
+                unit_costs.push_back(info != sku_info.end() ? info->second.unit_cost : 0.0);
+            }
+            skus.resize(fetch_size_);
+            warehouses.resize(fetch_size_);
+            totals.resize(fetch_size_);
+        }
+    }
+    tr.commit();
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    sku_ids_.swap(sku_ids);
+    warehouse_ids_.swap(warehouse_ids);
+    on_hand_.swap(on_hand);
+    reorder_points_.swap(reorder_points);
+    unit_costs_.swap(unit_costs);
+    row_index_.swap(row_index);
+    sku_info_.swap(sku_info);
+    watermark_ = std::move(watermark);
+}
+
+std::size_t StockSnapshot::refresh(soci::session& sql) {
+    std::lock_guard<std::mutex> refresh_lock(refresh_mutex_);
+
+    // watermark_ 只在持有 refresh_mutex_ 時修改，這裡不必再鎖 mutex_；
+    // 條件涵蓋 high-water mark 以上與仍在等待的 gap，讀到的都是還沒套用過的異動
+    const std::string pending = watermark_.pendingCondition("movement_id");
+
+    // 先把新異動讀進區域變數，讀資料庫時不持有寫鎖，查詢不會被擋住
+    std::vector<long long> new_ids;
+    std::vector<int> new_skus, new_warehouses, new_deltas;
+    {
+        std::vector<long long> ids(fetch_size_);
+        std::vector<int> skus(fetch_size_);
+        std::vector<int> warehouses(fetch_size_);
+        std::vector<int> deltas(fetch_size_);
+        soci::statement st = (sql.prepare <<
+            "SELECT movement_id, sku_id, warehouse_id, qty_delta "
+            "FROM stock_movements "
+            "WHERE " + pending + " "
+            "ORDER BY movement_id",
+            soci::into(ids), soci::into(skus), soci::into(warehouses), soci::into(deltas));
+        st.execute();
+        while (st.fetch()) {
+            new_ids.insert(new_ids.end(), ids.begin(), ids.end());
+            new_skus.insert(new_skus.end(), skus.begin(), skus.end());
+            new_warehouses.insert(new_warehouses.end(), warehouses.begin(), warehouses.end());
+            new_deltas.insert(new_deltas.end(), deltas.begin(), deltas.end());
+            ids.resize(fetch_size_);
+            skus.resize(fetch_size_);
+            warehouses.resize(fetch_size_);
+            deltas.resize(fetch_size_);
+        }
+    }
+
+    long long now = static_cast<long long>(std::time(nullptr));
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    for (std::size_t i = 0; i < new_ids.size(); ++i) {
+        applyLocked(new_skus[i], new_warehouses[i], new_deltas[i]);
+    }
+    // 沒讀到新資料也要跑 expire，太舊的 gap 視為已 rollback 的交易
+    watermark_.advance(std::move(new_ids), now);
+    watermark_.expire(now, max_gap_age_, gap_window_);
+    return new_skus.size();
+}
+
+void StockSnapshot::applyLocked(int sku_id, int warehouse_id, int qty_delta) {
+    auto it = row_index_.find(rowKey(sku_id, warehouse_id));
+    if (it != row_index_.end()) {
+        on_hand_[it->second] += qty_delta;
+        return;
+    }
+
+    // 新的 (sku, warehouse) 組合，附加在欄位尾端
+    auto info = sku_info_.find(sku_id);
+    row_index_.emplace(rowKey(sku_id, warehouse_id), static_cast<uint32_t>(sku_ids_.size()));
+    sku_ids_.push_back(sku_id);
+    warehouse_ids_.push_back(warehouse_id);
+    on_hand_.push_back(qty_delta);
+    reorder_points_.push_back(info != sku_info_.end() ? info->second.reorder_point : 0);
+    unit_costs_.push_back(info != sku_info_.end() ? info->second.unit_cost : 0.0);
+}
+
+int64_t StockSnapshot::totalForSku(int sku_id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return simd::sumWhereEqual(sku_ids_.data(), on_hand_.data(), on_hand_.size(), sku_id);
+}
+
+int64_t StockSnapshot::totalForWarehouse(int warehouse_id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return simd::sumWhereEqual(warehouse_ids_.data(), on_hand_.data(), on_hand_.size(), warehouse_id);
+}
+
+double StockSnapshot::valuation() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return simd::weightedSum(on_hand_.data(), unit_costs_.data(), on_hand_.size());
+}
+
+double StockSnapshot::valuationForWarehouse(int warehouse_id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return simd::weightedSumWhereEqual(warehouse_ids_.data(), on_hand_.data(),
+                                       unit_costs_.data(), on_hand_.size(), warehouse_id);
+}
+
+std::vector<StockLevel> StockSnapshot::lowStock() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::vector<uint32_t> rows;
+    simd::selectLess(on_hand_.data(), reorder_points_.data(), on_hand_.size(), rows);
+    return collect(rows);
+}
+
+std::vector<StockLevel> StockSnapshot::lowStock(int threshold) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::vector<uint32_t> rows;
+    simd::selectLessThan(on_hand_.data(), threshold, on_hand_.size(), rows);
+    return collect(rows);
+}
+
+std::vector<StockLevel> StockSnapshot::collect(const std::vector<uint32_t>& rows) const {
+    std::vector<StockLevel> levels;
+    levels.reserve(rows.size());
+    for (uint32_t row : rows) {
+        levels.push_back(StockLevel{sku_ids_[row], warehouse_ids_[row], on_hand_[row],
+                                    reorder_points_[row], unit_costs_[row]});
+    }
+    return levels;
+}
+
+std::size_t StockSnapshot::rowCount() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return sku_ids_.size();
+}
+
+long long StockSnapshot::lastMovementId() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return watermark_.highWater();
+}
+
+std::size_t StockSnapshot::openGaps() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return watermark_.gaps().size();
+}